@@ -0,0 +1,328 @@
+// Aliasing and spectral quality analysis across oversampling factors.
+//
+// Renders the oscillator over a grid of pitch, algorithm pair, amount and PM routing at
+// every oversampling factor, decimates back to the base rate and measures the spectrum:
+//   ASR  aliasing-to-signal ratio, power outside the harmonics over power in them.
+//        This includes any other non-harmonic content such as phase noise, which sets
+//        a floor around -100 dB.
+//   THD  power in harmonics 2 and up over the fundamental (intentional in PD, for reference)
+// and reports the minimum factor whose ASR meets the threshold for each setting.
+//
+//   analyze [threshold dB, default -60] [sample rate, default 48000]
+//
+// Decimation uses a windowed-sinc lowpass rather than Rack's resampler, so absolute
+// numbers near the band edge differ slightly from the module.
+
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <string>
+#include <vector>
+
+#include "dsp/PDO.hpp"
+#include "dsp/fft.hpp"
+
+using namespace infrasonic;
+using PDO = PhaseDistortionOscillator;
+
+static const double kPiD = 3.141592653589793;
+
+static const size_t kFftSize = 16384;
+static const float kWarmupTime = 0.25f;
+
+static const int kNumFactors = 5;
+static const int kFactors[kNumFactors] = {1, 2, 4, 8, 16};
+
+static const int kNumPitches = 4;
+static const float kPitches[kNumPitches] = {55.0f, 220.0f, 880.0f, 2640.0f};
+
+static const int kNumAmounts = 3;
+static const float kAmounts[kNumAmounts] = {0.25f, 0.5f, 1.0f};
+
+// PM depth used for both routings, as the squared knob value the module passes on
+static const float kPMAmount = 0.1f;
+
+// Decimation filter length per unit of oversampling
+static const int kDecimatorTaps = 96;
+
+// Bins either side of a harmonic counted as part of it, the main lobe of the window
+static const int kLobeBins = 4;
+
+static const char *kAlgoNames[PDO::PD_TYPE_CUSTOM] = {"bend", "sync", "pinch", "fold"};
+
+// Blackman-Harris windowed sinc lowpass, evaluated at the decimated rate only
+class Decimator
+{
+  public:
+    void Init(const int factor)
+    {
+        factor_ = factor;
+        const int len = kDecimatorTaps * factor + 1;
+        const double fc = 0.46 / factor;
+        const double mid = (len - 1) / 2.0;
+        coefs_.resize(len);
+        double sum = 0.0;
+        for (int i = 0; i < len; i++)
+        {
+            const double t = i - mid;
+            const double sinc = t == 0.0 ? 2.0 * fc : std::sin(2.0 * kPiD * fc * t) / (kPiD * t);
+            const double w = 2.0 * kPiD * i / (len - 1);
+            const double win = 0.35875 - 0.48829 * std::cos(w) + 0.14128 * std::cos(2.0 * w) - 0.01168 * std::cos(3.0 * w);
+            coefs_[i] = sinc * win;
+            sum += coefs_[i];
+        }
+        for (int i = 0; i < len; i++)
+            coefs_[i] /= sum;
+    }
+
+    inline size_t GetLength() const { return coefs_.size(); }
+
+    // out[m] filters the input ending at in[m * factor + length - 1]
+    void Process(const std::vector<float> &in, std::vector<float> &out) const
+    {
+        const size_t len = coefs_.size();
+        out.clear();
+        for (size_t start = 0; start + len <= in.size(); start += factor_)
+        {
+            double acc = 0.0;
+            for (size_t i = 0; i < len; i++)
+                acc += coefs_[i] * in[start + i];
+            out.push_back(static_cast<float>(acc));
+        }
+    }
+
+  private:
+    int factor_ = 1;
+    std::vector<double> coefs_;
+};
+
+struct Spectrum
+{
+    double asr_db, thd_db;
+};
+
+// Renders the main output at the base rate, num_samples after warmup
+static void render(const PDO::Patch &patch, const PDO::VoiceParams &voice, const float sample_rate,
+                   const int factor, const size_t num_samples, std::vector<float> &out)
+{
+    Decimator decimator;
+    decimator.Init(factor);
+
+    const size_t warmup = static_cast<size_t>(kWarmupTime * sample_rate);
+    const size_t base_len = warmup + num_samples + decimator.GetLength() / factor + 1;
+    const int block = 8 * factor;
+
+    PDO osc;
+    osc.Init(sample_rate * factor, sample_rate / 8);
+
+    std::vector<float> ext_pm(block, 0.0f), frames(block * 2);
+    std::vector<float> ovs;
+    ovs.reserve(base_len * factor + block);
+    while (ovs.size() < base_len * factor)
+    {
+        osc.ProcessBlock(patch, voice, ext_pm.data(), nullptr, frames.data(), block);
+        for (int i = 0; i < block; i++)
+            ovs.push_back(frames[i * 2]);
+    }
+
+    std::vector<float> base;
+    if (factor == 1)
+        base.swap(ovs);
+    else
+        decimator.Process(ovs, base);
+
+    out.assign(base.end() - num_samples, base.end());
+}
+
+// The fundamental sits exactly on a bin so harmonics do too. Aliases of harmonic h from
+// the sampling rate M * fs land at h * k - j * M * N bins, that is j * M * N (mod k) bins
+// away from the nearest harmonic. Picks the bin count near the target that keeps the low
+// order aliases at every factor clear of the harmonic main lobes, otherwise they would be
+// counted as signal.
+static size_t chooseFundamentalBin(const float target)
+{
+    static const int kAliasOrders = 4;
+    const size_t lo = static_cast<size_t>(std::max(target * 0.9f, static_cast<float>(kLobeBins * 2 + 3)));
+    const size_t hi = static_cast<size_t>(std::max(target * 1.1f, static_cast<float>(lo + 8)));
+
+    size_t best = lo;
+    long best_score = -1;
+    float best_error = 0.0f;
+    for (size_t k = lo; k <= hi; k++)
+    {
+        long score = static_cast<long>(k);
+        for (int f = 0; f < kNumFactors; f++)
+        {
+            for (int j = 1; j <= kAliasOrders; j++)
+            {
+                const size_t r = (static_cast<size_t>(j) * kFactors[f] * kFftSize) % k;
+                const long dist = static_cast<long>(std::min(r, k - r));
+                score = std::min(score, dist);
+            }
+        }
+        const float error = std::fabs(static_cast<float>(k) - target);
+        if (score > best_score || (score == best_score && error < best_error))
+        {
+            best = k;
+            best_score = score;
+            best_error = error;
+        }
+    }
+    return best;
+}
+
+static Spectrum analyze(const Fft &fft, const std::vector<float> &x, const size_t fund_bin)
+{
+    const size_t n = fft.GetSize();
+    std::vector<float> re(n), im(n, 0.0f);
+    for (size_t i = 0; i < n; i++)
+    {
+        const double w = 2.0 * kPiD * i / n;
+        const double win = 0.35875 - 0.48829 * std::cos(w) + 0.14128 * std::cos(2.0 * w) - 0.01168 * std::cos(3.0 * w);
+        re[i] = static_cast<float>(x[i] * win);
+    }
+    fft.Forward(re.data(), im.data());
+
+    // Classify every bin up to Nyquist as DC, harmonic or alias
+    const size_t nyquist = n / 2;
+    double fund = 0.0, harmonics = 0.0, aliases = 0.0;
+    for (size_t b = kLobeBins + 1; b < nyquist; b++)
+    {
+        const double p = static_cast<double>(re[b]) * re[b] + static_cast<double>(im[b]) * im[b];
+        const size_t h = (b + fund_bin / 2) / fund_bin;
+        const size_t dist = b > h * fund_bin ? b - h * fund_bin : h * fund_bin - b;
+        if (h >= 1 && dist <= static_cast<size_t>(kLobeBins))
+        {
+            if (h == 1)
+                fund += p;
+            else
+                harmonics += p;
+        }
+        else
+        {
+            aliases += p;
+        }
+    }
+
+    static const double kFloor = 1e-30;
+    Spectrum s;
+    s.asr_db = 10.0 * std::log10((aliases + kFloor) / (fund + harmonics + kFloor));
+    s.thd_db = 10.0 * std::log10((harmonics + kFloor) / (fund + kFloor));
+    return s;
+}
+
+// Upper median, which stays a valid factor index
+static int median(std::vector<int> values)
+{
+    std::sort(values.begin(), values.end());
+    return values.empty() ? 0 : values[values.size() / 2];
+}
+
+// Index into kFactors, or kNumFactors if no factor was enough
+static std::string factorLabel(const int f)
+{
+    return f < kNumFactors ? std::to_string(kFactors[f]) + "x" : ">" + std::to_string(kFactors[kNumFactors - 1]) + "x";
+}
+
+int main(int argc, char **argv)
+{
+    const double threshold_db = argc > 1 ? std::atof(argv[1]) : -60.0;
+    const float sample_rate = argc > 2 ? static_cast<float>(std::atof(argv[2])) : 48000.0f;
+
+    Fft fft;
+    fft.Init(kFftSize);
+
+    std::printf("ASR threshold %.1f dB at %.0f Hz, FFT size %zu\n\n", threshold_db, sample_rate, kFftSize);
+    std::printf("%8s %-6s %-6s %6s %-5s", "pitch", "warp A", "warp B", "amount", "pm");
+    for (int f = 0; f < kNumFactors; f++)
+        std::printf(" %7s", (std::to_string(kFactors[f]) + "x").c_str());
+    std::printf(" %8s %5s\n", "THD", "min");
+
+    // Minimum factor index of every setting, grouped for the summaries
+    int min_counts[kNumFactors + 1] = {};
+    std::vector<int> by_pitch[kNumPitches];
+    std::vector<int> by_pair[PDO::PD_TYPE_CUSTOM][PDO::PD_TYPE_CUSTOM];
+
+    std::vector<float> x;
+    for (int p = 0; p < kNumPitches; p++)
+    {
+        const size_t fund_bin = chooseFundamentalBin(kPitches[p] * kFftSize / sample_rate);
+        const float freq = fund_bin * sample_rate / kFftSize;
+
+        for (int a = 0; a < PDO::PD_TYPE_CUSTOM; a++)
+        {
+            for (int b = 0; b < PDO::PD_TYPE_CUSTOM; b++)
+            {
+                for (int m = 0; m < kNumAmounts; m++)
+                {
+                    for (int r = 0; r < PDO::ROUTING_PM_LAST; r++)
+                    {
+                        PDO::Patch patch;
+                        patch.pd_type[0] = static_cast<PDO::PhaseDistType>(a);
+                        patch.pd_type[1] = static_cast<PDO::PhaseDistType>(b);
+                        patch.routing = static_cast<PDO::Routing>(r);
+
+                        PDO::VoiceParams voice;
+                        voice.carrier_freq = freq;
+                        voice.pd_amt[0] = kAmounts[m];
+                        voice.pd_amt[1] = kAmounts[m];
+                        voice.pm_amt = kPMAmount;
+
+                        std::printf("%8.1f %-6s %-6s %6.2f %-5s", freq, kAlgoNames[a], kAlgoNames[b], kAmounts[m],
+                                    r == PDO::ROUTING_PM_PRE ? "pre" : "post");
+
+                        int min_factor = kNumFactors;
+                        double thd = 0.0;
+                        for (int f = 0; f < kNumFactors; f++)
+                        {
+                            render(patch, voice, sample_rate, kFactors[f], kFftSize, x);
+                            const Spectrum s = analyze(fft, x, fund_bin);
+                            std::printf(" %7.1f", s.asr_db);
+                            if (min_factor == kNumFactors && s.asr_db <= threshold_db)
+                                min_factor = f;
+                            thd = s.thd_db;
+                        }
+
+                        // THD is taken from the highest factor, the closest to the ideal waveform
+                        std::printf(" %8.1f %5s\n", thd, factorLabel(min_factor).c_str());
+
+                        min_counts[min_factor]++;
+                        by_pitch[p].push_back(min_factor);
+                        by_pair[a][b].push_back(min_factor);
+                    }
+                }
+            }
+        }
+    }
+
+    int total = 0;
+    for (int f = 0; f <= kNumFactors; f++)
+        total += min_counts[f];
+
+    std::printf("\nMinimum oversampling meeting %.1f dB ASR (settings, cumulative share):\n", threshold_db);
+    int met = 0;
+    for (int f = 0; f <= kNumFactors; f++)
+    {
+        met += min_counts[f];
+        std::printf("  %-5s %4d  %5.1f%%\n", factorLabel(f).c_str(), min_counts[f], 100.0 * met / total);
+    }
+
+    std::printf("\nMedian minimum factor by pitch:\n");
+    for (int p = 0; p < kNumPitches; p++)
+        std::printf("  %6.0f Hz  %s\n", kPitches[p], factorLabel(median(by_pitch[p])).c_str());
+
+    std::printf("\nMedian minimum factor by algorithm pair (rows warp A, columns warp B):\n%8s", "");
+    for (int b = 0; b < PDO::PD_TYPE_CUSTOM; b++)
+        std::printf(" %6s", kAlgoNames[b]);
+    std::printf("\n");
+    for (int a = 0; a < PDO::PD_TYPE_CUSTOM; a++)
+    {
+        std::printf("  %-6s", kAlgoNames[a]);
+        for (int b = 0; b < PDO::PD_TYPE_CUSTOM; b++)
+            std::printf(" %6s", factorLabel(median(by_pair[a][b])).c_str());
+        std::printf("\n");
+    }
+
+    return 0;
+}
@@ -0,0 +1,164 @@
+// Oscillator throughput benchmark for the portable DSP core.
+// Built once per SIMD backend by the Makefile in this directory.
+
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <vector>
+
+#include "dsp/PDO.hpp"
+
+using namespace infrasonic;
+
+static const float kSampleRate = 48000.0f;
+static const int kOversampling = 4;
+static const int kBlockSize = 8 * kOversampling;
+static const int kSeconds = 4;
+
+// Renders kSeconds of one voice, returns the cost per output sample at the engine rate in ns.
+// With sync_freq >= 0 the sync input is patched to a saw at that frequency, or to a constant -1 at 0.
+static double render(const PhaseDistortionOscillator::Patch &patch, double &checksum, const float sync_freq = -1.0f)
+{
+    using Clock = std::chrono::steady_clock;
+
+    const int num_blocks = static_cast<int>(kSampleRate) * kSeconds / 8;
+    std::vector<float> ext_pm(kBlockSize, 0.0f);
+    std::vector<float> out(kBlockSize * 2);
+
+    // Generated up front so only the oscillator is timed
+    std::vector<float> sync(num_blocks * kBlockSize, -1.0f);
+    if (sync_freq > 0.0f)
+    {
+        const float sync_inc = sync_freq / (kSampleRate * kOversampling);
+        float sync_phase = 0.0f;
+        for (size_t j = 0; j < sync.size(); j++)
+        {
+            sync[j] = sync_phase - 0.5f;
+            sync_phase += sync_inc;
+            sync_phase -= std::floor(sync_phase);
+        }
+    }
+
+    PhaseDistortionOscillator osc;
+    osc.Init(kSampleRate * kOversampling, kSampleRate / 8);
+
+    PhaseDistortionOscillator::VoiceParams voice;
+    voice.pm_amt = 0.25f;
+
+    const Clock::time_point start = Clock::now();
+    for (int i = 0; i < num_blocks; i++)
+    {
+        // Keep amounts moving so the smoothers never settle
+        voice.carrier_freq = 110.0f + (i & 255);
+        voice.pd_amt[0] = (i & 127) / 127.0f;
+        voice.pd_amt[1] = 1.0f - voice.pd_amt[0];
+        osc.ProcessBlock(patch, voice, ext_pm.data(), sync_freq >= 0.0f ? &sync[i * kBlockSize] : nullptr, out.data(), kBlockSize);
+        checksum += out[0];
+    }
+    const double elapsed = std::chrono::duration<double, std::nano>(Clock::now() - start).count();
+
+    return elapsed / (static_cast<double>(num_blocks) * 8);
+}
+
+// Renders kSeconds of one settled voice without PM, the case the wavetable engine covers
+static double renderHeld(const PhaseDistortionOscillator::Patch &patch, const float freq, double &checksum)
+{
+    using Clock = std::chrono::steady_clock;
+
+    const int num_blocks = static_cast<int>(kSampleRate) * kSeconds / 8;
+    std::vector<float> ext_pm(kBlockSize, 0.0f);
+    std::vector<float> out(kBlockSize * 2);
+
+    MipmapWavetable wavetable;
+    wavetable.Init();
+
+    PhaseDistortionOscillator osc;
+    osc.Init(kSampleRate * kOversampling, kSampleRate / 8);
+    osc.SetOutputRate(kSampleRate);
+    osc.SetWavetable(&wavetable);
+
+    PhaseDistortionOscillator::VoiceParams voice;
+    voice.carrier_freq = freq;
+    voice.pd_amt[0] = 0.6f;
+    voice.pd_amt[1] = 0.4f;
+
+    const Clock::time_point start = Clock::now();
+    for (int i = 0; i < num_blocks; i++)
+    {
+        osc.ProcessBlock(patch, voice, ext_pm.data(), nullptr, out.data(), kBlockSize);
+        checksum += out[0];
+    }
+    const double elapsed = std::chrono::duration<double, std::nano>(Clock::now() - start).count();
+
+    return elapsed / (static_cast<double>(num_blocks) * 8);
+}
+
+int main()
+{
+    using PDO = PhaseDistortionOscillator;
+
+    double checksum = 0.0;
+
+    std::printf("backend %-6s (%d lanes), %dx oversampling at %.0f Hz\n",
+                simd::vfloat::Name(), simd::vfloat::size, kOversampling, kSampleRate);
+    std::printf("%-10s %-10s %-6s %12s %12s %14s\n", "warp A", "warp B", "pm", "ns/sample", "fast tier", "voices @ 1 core");
+
+    static const char *names[PDO::PD_TYPE_LAST] = {"bend", "sync", "pinch", "fold", "custom"};
+
+    // S-curve with a kink, for the table lookup path
+    static const WarpTable::Point points[] = {{0.0f, 0.0f}, {0.2f, 0.05f}, {0.5f, 0.7f}, {0.8f, 0.9f}, {1.0f, 1.0f}};
+    WarpTable table;
+    table.Build(points, sizeof(points) / sizeof(points[0]));
+
+    double total_ns = 0.0, total_fast_ns = 0.0;
+    int num_runs = 0;
+
+    for (int a = 0; a < PDO::PD_TYPE_LAST; a++)
+    {
+        for (int b = 0; b < PDO::PD_TYPE_LAST; b++)
+        {
+            for (int r = 0; r < PDO::ROUTING_PM_LAST; r++)
+            {
+                PDO::Patch patch;
+                patch.pd_type[0] = static_cast<PDO::PhaseDistType>(a);
+                patch.pd_type[1] = static_cast<PDO::PhaseDistType>(b);
+                patch.routing = static_cast<PDO::Routing>(r);
+                patch.pm_ratio = 2.0f;
+                patch.warp_table = &table;
+
+                const double ns = render(patch, checksum);
+                patch.kernel_quality = PDO::KERNEL_QUALITY_FAST;
+                const double fast_ns = render(patch, checksum);
+
+                total_ns += ns;
+                total_fast_ns += fast_ns;
+                num_runs++;
+                std::printf("%-10s %-10s %-6s %12.1f %12.1f %14.0f\n", names[a], names[b], r == PDO::ROUTING_PM_PRE ? "pre" : "post",
+                            ns, fast_ns, 1e9 / (ns * kSampleRate));
+            }
+        }
+    }
+
+    const double mean = total_ns / num_runs;
+    std::printf("mean %.1f ns/sample (fast tier %.1f), %.0f voices @ 1 core (checksum %g)\n",
+                mean, total_fast_ns / num_runs, 1e9 / (mean * kSampleRate), checksum);
+
+    PDO::Patch held;
+    held.pd_type[1] = PDO::PD_TYPE_FOLD;
+    double held_checksum = 0.0;
+    const double held_ns = renderHeld(held, 880.0f, held_checksum);
+    held.wavetable_enabled = true;
+    const double wavetable_ns = renderHeld(held, 880.0f, held_checksum);
+    std::printf("held 880 Hz voice without PM %.1f ns/sample, from wavetable %.1f\n", held_ns, wavetable_ns);
+
+    // Sync costs the block engine a compare per step until an edge arrives
+    PDO::Patch synced;
+    synced.pm_ratio = 2.0f;
+    double sync_checksum = 0.0;
+    const double unsynced_ns = render(synced, sync_checksum);
+    const double idle_sync_ns = render(synced, sync_checksum, 0.0f);
+    const double sync_ns = render(synced, sync_checksum, 55.0f);
+    std::printf("sync unpatched %.1f ns/sample, patched without edges %.1f, 55 Hz master %.1f\n\n",
+                unsynced_ns, idle_sync_ns, sync_ns);
+    return 0;
+}
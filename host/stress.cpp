@@ -0,0 +1,559 @@
+// Denormal, NaN and performance cliff stress test for the portable DSP core.
+//
+// Drives the oscillator with adversarial and randomized patches and inputs, and fails on:
+//   non-finite  any NaN or infinity in the output
+//   recovery    a voice that doesn't play normally again once its inputs are back in range
+//   cliff       a scenario whose median block time is over kCliffRatio times the clean baseline
+//               for the same patch. Every scenario runs with denormals flushed, as on Rack's
+//               engine threads, and without, which is where a slow path would show.
+//   accuracy    the vector warp kernels straying from the scalar reference, swept to the edges
+//               of their amount range (near-zero bend, fold scaled up to 32)
+//   phase       a held voice whose carrier phase leaves 0-1, with wavetables on at pitches up
+//               to and past Nyquist
+//   denormals   flush-to-zero and denormals-are-zero not taking effect on the processing thread
+//
+// Built once per SIMD backend by the Makefile in this directory, exits non-zero on any failure.
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <functional>
+#include <limits>
+#include <random>
+#include <vector>
+
+#include "dsp/PDO.hpp"
+#include "dsp/denormals.hpp"
+
+using namespace infrasonic;
+using PDO = PhaseDistortionOscillator;
+
+static const float kSampleRate = 48000.0f;
+static const int kOversampling = 4;
+static const float kOvsRate = kSampleRate * kOversampling;
+static const int kBlockSize = 8 * kOversampling;
+
+// A second of blocks per scenario, and a quarter to recover in
+static const int kScenarioBlocks = static_cast<int>(kSampleRate) / 8;
+static const int kRecoveryBlocks = static_cast<int>(kSampleRate) / 32;
+
+static const double kCliffRatio = 3.0;
+
+static const int kFuzzTrials = 300;
+static const int kFuzzBlocks = 400;
+
+static const float kNaN = std::numeric_limits<float>::quiet_NaN();
+static const float kInf = std::numeric_limits<float>::infinity();
+static const float kDenormal = 1e-40f;
+
+static const char *kAlgoNames[PDO::PD_TYPE_LAST] = {"bend", "sync", "pinch", "fold", "custom"};
+
+// Inputs for block i: the voice, and kBlockSize samples of ext PM and sync.
+// Returns false to leave sync unpatched.
+typedef std::function<bool(const int i, PDO::VoiceParams &voice, float *ext_pm, float *sync)> Inputs;
+
+struct Scenario
+{
+    const char *name;
+    Inputs inputs;
+    // Allowed median block time over the baseline, for scenarios that legitimately do more work
+    double max_ratio;
+};
+
+struct Result
+{
+    double median_ns;
+    size_t non_finite;
+    bool recovered;
+};
+
+static int failures = 0;
+
+static void fail(const char *what)
+{
+    std::printf("  FAIL %s\n", what);
+    failures++;
+}
+
+static PDO::VoiceParams cleanVoice()
+{
+    PDO::VoiceParams voice;
+    voice.carrier_freq = 220.0f;
+    voice.pd_amt[0] = 0.5f;
+    voice.pd_amt[1] = 0.5f;
+    voice.pm_amt = 0.25f;
+    return voice;
+}
+
+static bool isFinite(const float *out, const size_t size)
+{
+    for (size_t i = 0; i < size; i++)
+        if (!std::isfinite(out[i]))
+            return false;
+    return true;
+}
+
+// Plays a clean voice for kRecoveryBlocks, true if the last 10 ms are finite and swing like a sine
+static bool recovers(PDO &osc, const PDO::Patch &patch)
+{
+    const PDO::VoiceParams voice = cleanVoice();
+    std::vector<float> ext_pm(kBlockSize, 0.0f);
+    std::vector<float> out(kBlockSize * 2);
+    const int tail = static_cast<int>(kOvsRate * 0.01f) / kBlockSize;
+    float lo = 0.0f, hi = 0.0f;
+    bool finite = true;
+
+    for (int i = 0; i < kRecoveryBlocks; i++)
+    {
+        osc.ProcessBlock(patch, voice, ext_pm.data(), nullptr, out.data(), kBlockSize);
+        if (i < kRecoveryBlocks - tail)
+            continue;
+        finite = finite && isFinite(out.data(), out.size());
+        for (int j = 0; j < kBlockSize; j++)
+        {
+            lo = std::min(lo, out[j * 2]);
+            hi = std::max(hi, out[j * 2]);
+        }
+    }
+    return finite && hi - lo > 1.0f;
+}
+
+static Result run(const PDO::Patch &patch, const Inputs &inputs, const int num_blocks)
+{
+    using Clock = std::chrono::steady_clock;
+
+    PDO osc;
+    osc.Init(kOvsRate, kSampleRate / 8);
+    osc.SetOutputRate(kSampleRate);
+
+    std::vector<float> ext_pm(kBlockSize), sync(kBlockSize), out(kBlockSize * 2);
+    // Only the second half is timed, once the smoothers have settled (or decayed)
+    std::vector<double> times;
+    Result result = {0.0, 0, false};
+
+    for (int i = 0; i < num_blocks; i++)
+    {
+        PDO::VoiceParams voice = cleanVoice();
+        std::fill(ext_pm.begin(), ext_pm.end(), 0.0f);
+        std::fill(sync.begin(), sync.end(), 0.0f);
+        const bool synced = inputs(i, voice, ext_pm.data(), sync.data());
+
+        const Clock::time_point start = Clock::now();
+        osc.ProcessBlock(patch, voice, ext_pm.data(), synced ? sync.data() : nullptr, out.data(), kBlockSize);
+        if (i >= num_blocks / 2)
+            times.push_back(std::chrono::duration<double, std::nano>(Clock::now() - start).count());
+
+        for (size_t j = 0; j < out.size(); j++)
+            result.non_finite += !std::isfinite(out[j]);
+    }
+
+    std::nth_element(times.begin(), times.begin() + times.size() / 2, times.end());
+    result.median_ns = times[times.size() / 2];
+    result.recovered = recovers(osc, patch);
+    return result;
+}
+
+// Fills a block of an input with one value, or alternates it in sign every `period` samples
+static void fill(float *in, const float value, const int period = 0)
+{
+    for (int j = 0; j < kBlockSize; j++)
+        in[j] = period > 0 && (j / period) % 2 ? -value : value;
+}
+
+static std::vector<Scenario> scenarios()
+{
+    std::vector<Scenario> list;
+
+    list.push_back({"clean", [](int, PDO::VoiceParams &, float *, float *) { return false; }, 1.0});
+
+    // -- ext PM --
+    list.push_back({"ext PM NaN", [](int, PDO::VoiceParams &, float *pm, float *) { fill(pm, kNaN); return false; }, kCliffRatio});
+    list.push_back({"ext PM +-inf", [](int i, PDO::VoiceParams &, float *pm, float *) { fill(pm, i % 2 ? kInf : -kInf); return false; }, kCliffRatio});
+    list.push_back({"ext PM +-1e30", [](int, PDO::VoiceParams &, float *pm, float *) { fill(pm, 1e30f, 1); return false; }, kCliffRatio});
+    list.push_back({"ext PM +-1e6 noise", [](int i, PDO::VoiceParams &, float *pm, float *) {
+        for (int j = 0; j < kBlockSize; j++)
+            pm[j] = 1e6f * std::sin(i * 12.9898f + j * 78.233f);
+        return false;
+    }, kCliffRatio});
+    list.push_back({"ext PM denormal", [](int, PDO::VoiceParams &, float *pm, float *) { fill(pm, kDenormal, 1); return false; }, kCliffRatio});
+
+    // -- sync, an edge every other block unless noted --
+    list.push_back({"sync NaN", [](int, PDO::VoiceParams &, float *, float *sync) { fill(sync, kNaN); return true; }, kCliffRatio});
+    list.push_back({"sync +-inf", [](int i, PDO::VoiceParams &, float *, float *sync) { fill(sync, i % 2 ? kInf : -kInf); return true; }, kCliffRatio});
+    list.push_back({"sync +-denormal", [](int i, PDO::VoiceParams &, float *, float *sync) { fill(sync, i % 2 ? kDenormal : -kDenormal); return true; }, kCliffRatio});
+    list.push_back({"sync +-1e38", [](int i, PDO::VoiceParams &, float *, float *sync) { fill(sync, i % 2 ? 1e38f : -3e38f); return true; }, kCliffRatio});
+    // An edge every other sample, the most the input can produce. Each costs a scalar evaluation.
+    list.push_back({"sync dense", [](int, PDO::VoiceParams &, float *, float *sync) { fill(sync, 1.0f, 1); return true; }, 16.0});
+
+    // -- pitch --
+    list.push_back({"pitch NaN", [](int, PDO::VoiceParams &v, float *, float *) { v.carrier_freq = kNaN; return false; }, kCliffRatio});
+    list.push_back({"pitch +inf", [](int, PDO::VoiceParams &v, float *, float *) { v.carrier_freq = kInf; return false; }, kCliffRatio});
+    list.push_back({"pitch -1 kHz", [](int, PDO::VoiceParams &v, float *, float *) { v.carrier_freq = -1000.0f; return false; }, kCliffRatio});
+    list.push_back({"pitch 1e9", [](int, PDO::VoiceParams &v, float *, float *) { v.carrier_freq = 1e9f; return false; }, kCliffRatio});
+    list.push_back({"pitch denormal", [](int, PDO::VoiceParams &v, float *, float *) { v.carrier_freq = kDenormal; return false; }, kCliffRatio});
+
+    // -- amounts --
+    list.push_back({"amounts NaN", [](int, PDO::VoiceParams &v, float *, float *) {
+        v.pd_amt[0] = v.pd_amt[1] = v.pm_amt = kNaN;
+        return false;
+    }, kCliffRatio});
+    list.push_back({"amounts -5 / 7", [](int i, PDO::VoiceParams &v, float *, float *) {
+        v.pd_amt[0] = v.pd_amt[1] = v.pm_amt = i % 2 ? 7.0f : -5.0f;
+        return false;
+    }, kCliffRatio});
+    list.push_back({"amounts denormal", [](int, PDO::VoiceParams &v, float *, float *) {
+        v.pd_amt[0] = v.pd_amt[1] = v.pm_amt = kDenormal;
+        return false;
+    }, kCliffRatio});
+    // Smoothers decaying from full scale toward zero for the rest of the run
+    list.push_back({"amounts released", [](int i, PDO::VoiceParams &v, float *, float *) {
+        v.pd_amt[0] = v.pd_amt[1] = v.pm_amt = i < 16 ? 1.0f : 0.0f;
+        return false;
+    }, kCliffRatio});
+    // Bend where its vector form switches to the identity
+    list.push_back({"amounts near zero", [](int i, PDO::VoiceParams &v, float *, float *) {
+        v.pd_amt[0] = v.pd_amt[1] = 1e-7f * std::pow(10.0f, (i % 64) / 16.0f);
+        v.pm_amt = 0.0f;
+        return false;
+    }, kCliffRatio});
+
+    return list;
+}
+
+// Adversarial inputs for each algorithm, both kernel tiers, with and without flushing
+static void testScenarios(const WarpTable &table)
+{
+    const std::vector<Scenario> list = scenarios();
+    std::vector<double> worst[2];
+    std::vector<size_t> non_finite(list.size(), 0);
+    std::vector<int> stuck(list.size(), 0);
+    worst[0].assign(list.size(), 0.0);
+    worst[1].assign(list.size(), 0.0);
+
+    for (int flush = 1; flush >= 0; flush--)
+    {
+        ScopedFlushDenormals scope(flush != 0);
+
+        for (int t = 0; t < PDO::PD_TYPE_LAST; t++)
+        {
+            for (int q = 0; q < PDO::KERNEL_QUALITY_LAST; q++)
+            {
+                PDO::Patch patch;
+                patch.pd_type[0] = patch.pd_type[1] = static_cast<PDO::PhaseDistType>(t);
+                patch.kernel_quality = static_cast<PDO::KernelQuality>(q);
+                patch.warp_table = &table;
+                patch.pm_ratio = 2.0f;
+                // Every other patch on the other routing, window and alt output
+                if ((t + q) % 2)
+                {
+                    patch.routing = PDO::ROUTING_PM_POST;
+                    patch.win_type = PDO::WIN_TYPE_TRI;
+                    patch.alt_out_type = PDO::OUT_TYPE_SUB;
+                    patch.phase_lock = true;
+                }
+
+                double baseline = 0.0;
+                for (size_t s = 0; s < list.size(); s++)
+                {
+                    const Result r = run(patch, list[s].inputs, kScenarioBlocks);
+                    if (s == 0)
+                        baseline = r.median_ns;
+                    worst[flush][s] = std::max(worst[flush][s], r.median_ns / baseline);
+                    non_finite[s] += r.non_finite;
+                    stuck[s] += !r.recovered;
+                }
+            }
+        }
+    }
+
+    std::printf("%-20s %14s %14s %12s %10s\n", "scenario", "cliff (ftz)", "cliff (no ftz)", "non-finite", "stuck");
+    for (size_t s = 0; s < list.size(); s++)
+    {
+        std::printf("%-20s %13.2fx %13.2fx %12zu %10d\n", list[s].name, worst[1][s], worst[0][s], non_finite[s], stuck[s]);
+        if (worst[1][s] > list[s].max_ratio || worst[0][s] > list[s].max_ratio)
+            fail("slow path, block time over the allowed ratio");
+        if (non_finite[s] > 0)
+            fail("non-finite output");
+        if (stuck[s] > 0)
+            fail("voice did not recover");
+    }
+}
+
+// Vector kernels of the block engine against the scalar ones of Evaluate(), at settled amounts.
+// A second voice warped by nothing reports the carrier phase on its phasor output.
+static void testAccuracy(const WarpTable &table)
+{
+    static const float amounts[] = {0.0f, 1e-7f, 1e-6f, 1e-5f, 1.1e-5f, 2e-5f, 5e-5f, 1e-4f, 3e-4f, 1e-3f, 1e-2f, 0.1f, 0.5f, 0.9f, 1.0f};
+    static const float tolerance[PDO::KERNEL_QUALITY_LAST] = {1e-4f, 1e-2f};
+    const int num_amounts = sizeof(amounts) / sizeof(amounts[0]);
+    const int warmup = static_cast<int>(kOvsRate * 0.5f) / kBlockSize;
+
+    std::printf("\n%-8s %14s %14s %14s\n", "warp", "max error", "fast tier", "worst amount");
+
+    for (int t = 0; t < PDO::PD_TYPE_LAST; t++)
+    {
+        float max_error[PDO::KERNEL_QUALITY_LAST] = {};
+        float worst_amount = 0.0f;
+
+        for (int q = 0; q < PDO::KERNEL_QUALITY_LAST; q++)
+        {
+            for (int a = 0; a < num_amounts; a++)
+            {
+                PDO::Patch patch, ref_patch;
+                patch.pd_type[0] = static_cast<PDO::PhaseDistType>(t);
+                patch.pd_type[1] = PDO::PD_TYPE_BEND;
+                patch.kernel_quality = static_cast<PDO::KernelQuality>(q);
+                patch.warp_table = &table;
+                ref_patch.alt_out_type = PDO::OUT_TYPE_PHASOR;
+
+                PDO::VoiceParams voice, ref_voice;
+                voice.carrier_freq = ref_voice.carrier_freq = 220.0f;
+                voice.pd_amt[0] = amounts[a];
+
+                PDO osc, ref;
+                osc.Init(kOvsRate, kSampleRate / 8);
+                ref.Init(kOvsRate, kSampleRate / 8);
+
+                std::vector<float> ext_pm(kBlockSize, 0.0f), out(kBlockSize * 2), ref_out(kBlockSize * 2);
+                for (int i = 0; i < warmup + 64; i++)
+                {
+                    osc.ProcessBlock(patch, voice, ext_pm.data(), nullptr, out.data(), kBlockSize);
+                    ref.ProcessBlock(ref_patch, ref_voice, ext_pm.data(), nullptr, ref_out.data(), kBlockSize);
+                    if (i < warmup)
+                        continue;
+                    for (int j = 0; j < kBlockSize; j++)
+                    {
+                        float warped, expected;
+                        PDO::Evaluate(patch, voice, ref_out[j * 2 + 1], &warped, &expected);
+                        const float error = std::fabs(out[j * 2] - expected);
+                        if (!(error <= max_error[q]))
+                        {
+                            max_error[q] = error;
+                            worst_amount = amounts[a];
+                        }
+                    }
+                }
+            }
+        }
+
+        std::printf("%-8s %14.2e %14.2e %14g\n", kAlgoNames[t], max_error[0], max_error[1], worst_amount);
+        for (int q = 0; q < PDO::KERNEL_QUALITY_LAST; q++)
+            if (!(max_error[q] <= tolerance[q]))
+                fail("vector kernel off the scalar reference");
+    }
+}
+
+// Held voices with wavetables on, from well inside the table's range to past Nyquist, where a
+// SIMD step covers whole cycles. They settle, so they play from the table wherever it can hold
+// them. The window reads the raw carrier phase, so a phase out of 0-1 shows in the peak.
+static void testHeld(const WarpTable &table)
+{
+    // Fractions of the oscillator's sample rate
+    static const float pitches[] = {0.05f, 0.1f, 0.12f, 0.13f, 0.24f, 0.26f, 0.4f, 0.5f, 2.0f, 1e6f, kInf};
+    static const int factors[] = {1, kOversampling, 16};
+    static const PDO::WindowType windows[] = {PDO::WIN_TYPE_SAW, PDO::WIN_TYPE_TRI};
+    static const float kMaxPeak = 1.25f;
+    const int num_blocks = kScenarioBlocks / 4;
+
+    size_t non_finite = 0;
+    int stuck = 0, num_voices = 0;
+    float peak = 0.0f;
+
+    MipmapWavetable wavetable;
+    wavetable.Init();
+
+    for (const int factor : factors)
+    {
+        for (const float pitch : pitches)
+        {
+            for (const PDO::WindowType window : windows)
+            {
+                const float rate = kSampleRate * factor;
+                PDO::Patch patch;
+                patch.pd_type[1] = PDO::PD_TYPE_FOLD;
+                patch.win_type = window;
+                patch.wavetable_enabled = true;
+                patch.warp_table = &table;
+
+                PDO::VoiceParams voice;
+                voice.carrier_freq = pitch * rate;
+                voice.pd_amt[0] = 0.3f;
+                voice.pd_amt[1] = 0.6f;
+
+                PDO osc;
+                osc.Init(rate, kSampleRate / 8);
+                osc.SetOutputRate(kSampleRate);
+                osc.SetWavetable(&wavetable);
+
+                std::vector<float> ext_pm(kBlockSize, 0.0f), out(kBlockSize * 2);
+                for (int i = 0; i < num_blocks; i++)
+                {
+                    osc.ProcessBlock(patch, voice, ext_pm.data(), nullptr, out.data(), kBlockSize);
+                    non_finite += !isFinite(out.data(), out.size());
+                    for (const float x : out)
+                        peak = std::max(peak, std::fabs(x));
+                }
+                stuck += !recovers(osc, patch);
+                num_voices++;
+            }
+        }
+    }
+
+    std::printf("\nheld: %d voices up to and past Nyquist, peak %.3f, %zu non-finite blocks, %d stuck\n",
+                num_voices, peak, non_finite, stuck);
+    if (!(peak <= kMaxPeak))
+        fail("carrier phase out of range");
+    if (non_finite > 0)
+        fail("non-finite output");
+    if (stuck > 0)
+        fail("voice did not recover");
+}
+
+// Random patches, voices and inputs, with adversarial values mixed in, through both the block
+// and the control rate paths. Sample rate changes and resets on the way, as the module makes them.
+static void testFuzz(const WarpTable &table)
+{
+    static const float ratios[] = {0.25f, 1.0f / 3.0f, 0.5f, 1.5f, 2.5f, 3.5f, 4.0f / 3.0f, 5.0f / 3.0f, 1.0f, 2.0f, 3.0f, 8.0f};
+    static const float specials[] = {kNaN, kInf, -kInf, 0.0f, -0.0f, kDenormal, -kDenormal, 1e30f, -1e30f, 1e-30f, -1.0f, 2.0f};
+    static const int factors[] = {1, 2, 4, 8, 16};
+
+    std::mt19937 rng(1234);
+    std::uniform_real_distribution<float> unit(0.0f, 1.0f);
+    auto pick = [&rng](const int n) { return static_cast<int>(rng() % n); };
+    auto value = [&](const float normal) {
+        return unit(rng) < 0.1f ? specials[pick(sizeof(specials) / sizeof(specials[0]))] : normal;
+    };
+
+    size_t non_finite = 0;
+    int stuck = 0;
+    double max_ns = 0.0;
+
+    // Swapped in and out as the module does when its voice count changes
+    MipmapWavetable wavetables[2];
+    for (MipmapWavetable &wavetable : wavetables)
+        wavetable.Init();
+
+    for (int trial = 0; trial < kFuzzTrials; trial++)
+    {
+        PDO::Patch patch;
+        patch.pd_type[0] = static_cast<PDO::PhaseDistType>(pick(PDO::PD_TYPE_LAST));
+        patch.pd_type[1] = static_cast<PDO::PhaseDistType>(pick(PDO::PD_TYPE_LAST));
+        patch.routing = static_cast<PDO::Routing>(pick(PDO::ROUTING_PM_LAST));
+        patch.win_type = static_cast<PDO::WindowType>(pick(PDO::WIN_TYPE_LAST));
+        patch.alt_out_type = static_cast<PDO::AltOutputType>(pick(PDO::OUT_TYPE_LAST));
+        patch.kernel_quality = static_cast<PDO::KernelQuality>(pick(PDO::KERNEL_QUALITY_LAST));
+        patch.alt_out_enabled = pick(4) != 0;
+        patch.phase_lock = pick(2) != 0;
+        patch.wavetable_enabled = pick(2) != 0;
+        patch.pm_ratio = ratios[pick(sizeof(ratios) / sizeof(ratios[0]))];
+        patch.warp_table = pick(4) ? &table : nullptr;
+
+        float rate = kSampleRate * factors[pick(5)];
+        PDO osc;
+        osc.Init(rate, kSampleRate / 8);
+        osc.SetOutputRate(kSampleRate);
+        osc.SetWavetable(&wavetables[0]);
+
+        std::vector<float> ext_pm(kBlockSize), sync(kBlockSize), out(kBlockSize * 2);
+        float sync_phase = 0.0f;
+
+        for (int i = 0; i < kFuzzBlocks; i++)
+        {
+            if (pick(200) == 0)
+            {
+                rate = kSampleRate * factors[pick(5)];
+                osc.SetSampleRate(rate);
+            }
+            if (pick(200) == 0)
+                osc.Reset();
+            if (pick(100) == 0)
+            {
+                const int next = pick(3);
+                osc.SetWavetable(next < 2 ? &wavetables[next] : nullptr);
+            }
+
+            PDO::VoiceParams voice;
+            voice.carrier_freq = value(20.0f * std::pow(2.0f, unit(rng) * 10.0f));
+            voice.pd_amt[0] = value(unit(rng));
+            voice.pd_amt[1] = value(unit(rng));
+            voice.pm_amt = value(unit(rng) < 0.5f ? 0.0f : unit(rng));
+
+            const int pm_mode = pick(4);
+            const float pm_level = value(unit(rng) * 2.0f - 1.0f);
+            for (int j = 0; j < kBlockSize; j++)
+                ext_pm[j] = pm_mode == 0 ? 0.0f : pm_mode == 1 ? pm_level : value(unit(rng) * 2.0f - 1.0f);
+
+            const bool synced = pick(3) == 0;
+            const float sync_inc = unit(rng) * 0.1f;
+            for (int j = 0; j < kBlockSize; j++)
+            {
+                sync_phase += sync_inc;
+                sync_phase -= std::floor(sync_phase);
+                sync[j] = value(sync_phase - 0.5f);
+            }
+
+            using Clock = std::chrono::steady_clock;
+            const Clock::time_point start = Clock::now();
+            osc.ProcessBlock(patch, voice, ext_pm.data(), synced ? sync.data() : nullptr, out.data(), kBlockSize);
+            max_ns = std::max(max_ns, std::chrono::duration<double, std::nano>(Clock::now() - start).count());
+            non_finite += !isFinite(out.data(), out.size());
+
+            float ctl_out[2];
+            osc.ProcessControl(patch, voice, ext_pm[0], synced && sync[0] > 0.0f, ctl_out);
+            non_finite += !isFinite(ctl_out, 2);
+        }
+
+        osc.SetSampleRate(kOvsRate);
+        stuck += !recovers(osc, patch);
+    }
+
+    std::printf("\nfuzz: %d patches of %d blocks, %zu non-finite blocks, %d stuck, slowest block %.1f us\n",
+                kFuzzTrials, kFuzzBlocks, non_finite, stuck, max_ns * 1e-3);
+    if (non_finite > 0)
+        fail("non-finite output");
+    if (stuck > 0)
+        fail("voice did not recover");
+}
+
+static void testDenormals()
+{
+    const bool at_start = DenormalsFlushed();
+    bool on, off;
+    {
+        ScopedFlushDenormals flush(true);
+        volatile float tiny = 1e-30f;
+        const float product = tiny * 1e-15f;
+        on = DenormalsFlushed() && product == 0.0f;
+        {
+            ScopedFlushDenormals no_flush(false);
+            off = !DenormalsFlushed();
+        }
+        on = on && DenormalsFlushed();
+    }
+
+    std::printf("denormals flushed at start %s, in scope %s, off in nested scope %s, restored %s\n",
+                at_start ? "yes" : "no", on ? "yes" : "no", off ? "yes" : "no",
+                DenormalsFlushed() == at_start ? "yes" : "no");
+    if (!on || DenormalsFlushed() != at_start)
+        fail("flush-to-zero not set on the processing thread");
+}
+
+int main()
+{
+    std::printf("backend %-6s (%d lanes), %dx oversampling at %.0f Hz\n",
+                simd::vfloat::Name(), simd::vfloat::size, kOversampling, kSampleRate);
+
+    static const WarpTable::Point points[] = {{0.0f, 0.0f}, {0.2f, 0.05f}, {0.5f, 0.7f}, {0.8f, 0.9f}, {1.0f, 1.0f}};
+    WarpTable table;
+    table.Build(points, sizeof(points) / sizeof(points[0]));
+
+    testDenormals();
+    testScenarios(table);
+    testAccuracy(table);
+    testHeld(table);
+    testFuzz(table);
+
+    std::printf("%d failures\n\n", failures);
+    return failures > 0 ? 1 : 0;
+}
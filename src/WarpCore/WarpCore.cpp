@@ -1,9 +1,32 @@
 #include "../plugin.hpp"
 #include "../components.hpp"
 #include "../dsp/PDO.hpp"
+#include "../dsp/aligned_buffer.hpp"
+#include "../dsp/denormals.hpp"
+#include "../dsp/governor.hpp"
+#include "../dsp/handoff.hpp"
+#include "../dsp/shared_tables.hpp"
+#include "../dsp/upsampler.hpp"
+#include "../dsp/warp_table.hpp"
+#include "../dsp/wavetable.hpp"
+#include "WarpScope.hpp"
+#include <osdialog.h>
+#include <chrono>
+#include <mutex>
+#include <fstream>
+#include <sstream>
 
 using namespace rack::simd;
 
+// Interpolation filter length per oversampled phase for EXT PM.
+// A single tap is a zero-order hold.
+static const size_t NUM_EXT_PM_QUALITIES = 4;
+static const size_t EXT_PM_TAPS[NUM_EXT_PM_QUALITIES] = {1, 4, 8, 16};
+
+// CPU governor budgets as a fraction of real time, 0 is off
+static const size_t NUM_CPU_BUDGETS = 5;
+static const float CPU_BUDGETS[NUM_CPU_BUDGETS] = {0.0f, 0.02f, 0.05f, 0.1f, 0.2f};
+
 static const size_t NUM_PM_RATIOS = 16;
 static const unsigned int PM_RATIOS[NUM_PM_RATIOS][2] = {
 	// FIRST HALF - divisions and alternate ratios
@@ -14,12 +37,60 @@ static const unsigned int PM_RATIOS[NUM_PM_RATIOS][2] = {
 	{5, 1}, {6, 1}, {7, 1}, {8, 1}
 };
 
+// Reads a custom warp curve from text, one point per line as "x y" (comma or whitespace
+// separated) or one "y" per line for evenly spaced points. Blank lines and # comments are skipped.
+// "x y" points may come in any order, they are sorted by x as WarpTable requires.
+static bool parseWarpCurve(std::istream& in, std::vector<infrasonic::WarpTable::Point>& points) {
+	std::vector<std::vector<float>> rows;
+	std::string line;
+	while (std::getline(in, line)) {
+		line = line.substr(0, line.find('#'));
+		std::replace(line.begin(), line.end(), ',', ' ');
+		std::istringstream fields(line);
+		std::vector<float> row;
+		float v;
+		while (fields >> v) row.push_back(v);
+		if (!fields.eof()) return false;
+		if (row.empty()) continue;
+		if (row.size() > 2 || (!rows.empty() && row.size() != rows[0].size())) return false;
+		rows.push_back(row);
+	}
+
+	points.clear();
+	for (size_t i = 0; i < rows.size(); i++) {
+		if (rows[i].size() == 2) {
+			if (!std::isfinite(rows[i][0])) return false;
+			points.push_back({rows[i][0], rows[i][1]});
+		} else {
+			const float x = rows.size() > 1 ? static_cast<float>(i) / (rows.size() - 1) : 0.0f;
+			points.push_back({x, rows[i][0]});
+		}
+	}
+	// Stable, so points sharing an x (a vertical step) keep their order from the file
+	std::stable_sort(points.begin(), points.end(), [](const infrasonic::WarpTable::Point& a, const infrasonic::WarpTable::Point& b) {
+		return a.x < b.x;
+	});
+	return points.size() >= 2 && points.size() <= infrasonic::WarpTable::kMaxPoints;
+}
+
 struct WarpCore : Module {
 
 	using Routing = infrasonic::PhaseDistortionOscillator::Routing;
 	using PDType = infrasonic::PhaseDistortionOscillator::PhaseDistType;
 	using WinType = infrasonic::PhaseDistortionOscillator::WindowType;
 	using OutType = infrasonic::PhaseDistortionOscillator::AltOutputType;
+	using VoiceParams = infrasonic::PhaseDistortionOscillator::VoiceParams;
+	using KernelQuality = infrasonic::PhaseDistortionOscillator::KernelQuality;
+	using Upsampler = infrasonic::simd::PolyphaseUpsampler;
+	using vfloat = infrasonic::simd::vfloat;
+	using WarpTable = infrasonic::WarpTable;
+	using SharedWarpTable = std::shared_ptr<const WarpTable>;
+
+	enum FreqRange {
+		RANGE_AUDIO,
+		RANGE_LFO,
+		RANGE_LAST
+	};
 
 	enum ParamId {
 		TUNE_COARSE_PARAM,
@@ -41,6 +112,7 @@ struct WarpCore : Module {
 		PITCH_CV_INPUT,
 		PM_CV_INPUT,
 		EXT_PM_INPUT,
+		SYNC_INPUT,
 		INPUTS_LEN
 	};
 	enum OutputId {
@@ -53,8 +125,16 @@ struct WarpCore : Module {
 		LIGHTS_LEN
 	};
 		
-	bool ratioMode = false;
+	std::atomic_bool ratioMode = ATOMIC_VAR_INIT(false);
+	std::atomic_bool displayEnabled = ATOMIC_VAR_INIT(true);
+
+	// Audio thread -> panel display, published at a decimated rate
+	infrasonic::WarpScopeQueue scopeQueue;
 
+	// Latest custom warp curve, UI thread only. Null when none is loaded.
+	SharedWarpTable warpTableUI;
+
+	// Called on the UI thread when a panel button changes a warp algorithm
 	std::function<void(void)> onAlgoChanged = nullptr;
 
 	WarpCore() {
@@ -75,18 +155,41 @@ struct WarpCore : Module {
 		configInput(PITCH_CV_INPUT, "V/Oct Pitch CV");
 		configInput(PM_CV_INPUT, "Internal PM Level CV");
 		configInput(EXT_PM_INPUT, "External PM Signal");
+		configInput(SYNC_INPUT, "Hard Sync");
 		configOutput(OSC_0_DEG_OUTPUT, "Main");
 		configOutput(OSC_90_DEG_OUTPUT, "Auxiliary");
 
+		// Built for the engine's current rate, so the audio thread never has to rebuild it
+		sampleRate = APP->engine->getSampleRate();
+		engineSampleRate = sampleRate;
 		for (int c = 0; c < kMaxChannels; c++)
-			osc[c].Init(srConfig.sampleRate * srConfig.oversampling);
+			osc[c].Init(sampleRate * settings.oversampling, sampleRate / kBlockSize);
 
+		// The first config is built here and applied directly, later ones go through configHandoff
+		activeConfig = buildEngineConfig();
+		governor.Init(sampleRate / kBlockSize, activeConfig->numStages - 1);
+		outputStaging.Resize(kBlockSize);
+		reconfigureEngine();
 		setRatioIndex(8);
+		setPhaseLock(settings.phaseLock);
+		setWavetable(settings.wavetable);
+
+		uiDivider.setDivision(kUIDivision);
 	}
 
+	~WarpCore() {
+		delete warpTable;
+		delete wavetableBank;
+		delete pendingConfig;
+		delete activeConfig;
+	}
+
+	// Not necessarily called on the UI thread, hence the lock. The audio thread keeps the old
+	// config until this one arrives, at most a block later.
 	void onSampleRateChange(const SampleRateChangeEvent& e) override {
-		srConfig.sampleRate = e.sampleRate;
-		needsSampleRateUpdate = true;
+		std::lock_guard<std::mutex> lock(configMutex);
+		engineSampleRate = e.sampleRate;
+		publishEngineConfig();
 	}
 
 	void onReset(const ResetEvent& e) override {
@@ -97,18 +200,38 @@ struct WarpCore : Module {
 
 	void onRandomize(const RandomizeEvent& e) override {
 		Module::onRandomize(e);
-		patch.pd_type[0] = static_cast<PDType>(rand() % PDType::PD_TYPE_LAST);
-		patch.pd_type[1] = static_cast<PDType>(rand() % PDType::PD_TYPE_LAST);
+		setWarpAlgorithm(0, rand() % getNumWarpAlgorithms());
+		setWarpAlgorithm(1, rand() % getNumWarpAlgorithms());
 		setRatioIndex(rand() % NUM_PM_RATIOS);
 	}
 
 	json_t* dataToJson() override {
+		// Include any changes made from the panel since the UI last looked
+		pollEvents();
+
 		json_t* json = json_object();
-		json_object_set_new(json, "oversampling", json_integer(srConfig.oversampling));
-		json_object_set_new(json, "pd_type_1", json_integer(patch.pd_type[0]));
-		json_object_set_new(json, "pd_type_2", json_integer(patch.pd_type[1]));
-		json_object_set_new(json, "pm_ratio", json_integer(ratioIndex));
-		json_object_set_new(json, "alt_out_type", json_integer(patch.alt_out_type));
+		json_object_set_new(json, "oversampling", json_integer(settings.oversampling));
+		json_object_set_new(json, "pd_type_1", json_integer(settings.pdType[0]));
+		json_object_set_new(json, "pd_type_2", json_integer(settings.pdType[1]));
+		json_object_set_new(json, "pm_ratio", json_integer(settings.ratioIndex));
+		json_object_set_new(json, "alt_out_type", json_integer(settings.altOutType));
+		json_object_set_new(json, "freq_range", json_integer(settings.freqRange));
+		json_object_set_new(json, "ext_pm_quality", json_integer(settings.extPMQuality));
+		json_object_set_new(json, "display", json_boolean(displayEnabled.load()));
+		json_object_set_new(json, "cpu_budget", json_integer(settings.cpuBudget));
+		json_object_set_new(json, "phase_lock", json_boolean(settings.phaseLock));
+		json_object_set_new(json, "wavetable", json_boolean(settings.wavetable));
+		if (warpTableUI) {
+			json_t* curve = json_array();
+			for (size_t i = 0; i < warpTableUI->GetNumPoints(); i++) {
+				const WarpTable::Point& p = warpTableUI->GetPoints()[i];
+				json_t* point = json_array();
+				json_array_append_new(point, json_real(p.x));
+				json_array_append_new(point, json_real(p.y));
+				json_array_append_new(curve, point);
+			}
+			json_object_set_new(json, "warp_curve", curve);
+		}
 		return json;
 	}
 
@@ -117,133 +240,493 @@ struct WarpCore : Module {
 		if (ovs) setOversampling(static_cast<unsigned int>(json_integer_value(ovs)));
 
 		json_t* pdType1 = json_object_get(rootJ, "pd_type_1");
-		if (pdType1) patch.pd_type[0] = static_cast<PDType>(json_integer_value(pdType1));
+		if (pdType1) setWarpAlgorithm(0, json_integer_value(pdType1));
 
 		json_t* pdType2 = json_object_get(rootJ, "pd_type_2");
-		if (pdType2) patch.pd_type[1] = static_cast<PDType>(json_integer_value(pdType2));
+		if (pdType2) setWarpAlgorithm(1, json_integer_value(pdType2));
 
 		json_t* ratioIndex = json_object_get(rootJ, "pm_ratio");
 		if (ratioIndex) setRatioIndex(json_integer_value(ratioIndex));
 
 		json_t* altOutType = json_object_get(rootJ, "alt_out_type");
 		if (altOutType) setAltOutputType(json_integer_value(altOutType));
+
+		json_t* range = json_object_get(rootJ, "freq_range");
+		if (range) setFreqRange(json_integer_value(range));
+
+		json_t* extPMQuality = json_object_get(rootJ, "ext_pm_quality");
+		if (extPMQuality) setExtPMQuality(json_integer_value(extPMQuality));
+
+		json_t* display = json_object_get(rootJ, "display");
+		if (display) displayEnabled = json_boolean_value(display);
+
+		json_t* budget = json_object_get(rootJ, "cpu_budget");
+		if (budget) setCpuBudget(json_integer_value(budget));
+
+		// Patches from before phase lock existed keep free running modulators
+		json_t* phaseLock = json_object_get(rootJ, "phase_lock");
+		setPhaseLock(phaseLock && json_boolean_value(phaseLock));
+
+		json_t* wavetable = json_object_get(rootJ, "wavetable");
+		setWavetable(wavetable && json_boolean_value(wavetable));
+
+		std::vector<WarpTable::Point> points;
+		json_t* curve = json_object_get(rootJ, "warp_curve");
+		size_t i;
+		json_t* point;
+		json_array_foreach(curve, i, point) {
+			points.push_back({
+				static_cast<float>(json_number_value(json_array_get(point, 0))),
+				static_cast<float>(json_number_value(json_array_get(point, 1)))
+			});
+		}
+		setWarpCurve(points);
 	}
 
 	void process(const ProcessArgs& args) override {
 
 		const int numChannels = std::max(inputs[PITCH_CV_INPUT].getChannels(), 1);
 
-		if (needsSampleRateUpdate) {
-			for (int c = 0; c < kMaxChannels; c++) {
-				osc[c].SetSampleRate(srConfig.sampleRate * srConfig.oversampling);
-				extPMBuffers[c].clear();
-			}
-			outputBuffer.clear();
-			needsSampleRateUpdate = false;
+		// Checked against the config at the next block boundary
+		sampleRate = args.sampleRate;
+
+		// Scheduling tiers:
+		// - UI rate (every kUIDivision samples): lights and display snapshots
+		// - Block rate (every kBlockSize samples): UI commands, param snapshot, buttons, per-voice params, engine
+		// - Audio rate (every sample): ext PM and sync staging and output playback
+		if (uiDivider.process()) {
+			processUIRate();
+		}
+
+		if (freqRange == RANGE_LFO) {
+			processControlRate(numChannels);
+		} else {
+			processAudioRate(numChannels);
 		}
 
-		const float sampleRate = srConfig.sampleRate;
-		const int oversampling = srConfig.oversampling;
+		outputs[OSC_0_DEG_OUTPUT].setChannels(numChannels);
+		outputs[OSC_90_DEG_OUTPUT].setChannels(numChannels);
+	}
+
+	// Full engine: oversampled, block-processed and resampled back down to the engine rate.
+	// Inputs are staged and outputs played back one sample per call, and every kBlockSize
+	// samples the staged block is run through the engine, so latency is exactly kBlockSize.
+	void processAudioRate(const int numChannels) {
+
+		processFade();
+
+		const int oversampling = stage->oversampling;
 		const int ovsBlockSize = kBlockSize * oversampling;
+		const int inputStride = stage->inputStride;
+		float* extPMStaging = stage->extPMStaging.Data();
+		float* syncStaging = stage->syncStaging.Data();
+
+		// Stage ext PM input (needs to be processed at audio rate despite buffering).
+		// Interpolated to the oversampled rate one SIMD group of channels at a time,
+		// written straight into the staging block. While unpatched, the upsamplers run on
+		// silence only until their history has drained, after which the staging stays zero
+		// and is skipped. That is a large share of an unpatched mono instance's cost.
+		if (inputs[EXT_PM_INPUT].isConnected()) {
+			extPMIdleSamples = 0;
+		}
+		if (extPMIdleSamples < kExtPMDrainSamples) {
+			float extpm[kMaxChannels] = {};
+			for (int c = 0; c < numChannels; c += 4) {
+				float_4 v = inputs[EXT_PM_INPUT].getPolyVoltageSimd<float_4>(c) / 10.0f;
+				v.store(&extpm[c]);
+			}
+			for (int g = 0; g < numChannels; g += vfloat::size) {
+				vfloat extpmOvs[Upsampler::kMaxFactor];
+				stage->extPMUpsamplers[g / vfloat::size].Process(vfloat::Load(&extpm[g]), extpmOvs);
+				const int groupEnd = std::min(g + vfloat::size, numChannels);
+				for (int i = 0; i < oversampling; i++) {
+					float lanes[vfloat::size];
+					extpmOvs[i].Store(lanes);
+					for (int c = g; c < groupEnd; c++) {
+						extPMStaging[c * inputStride + blockPos * oversampling + i] = lanes[c - g];
+					}
+				}
+			}
+			if (!inputs[EXT_PM_INPUT].isConnected() && ++extPMIdleSamples == kExtPMDrainSamples) {
+				// Also clears channels the drain did not reach, should the channel count rise later
+				stage->extPMStaging.Clear();
+				for (int g = 0; g < kNumSimdGroups; g++) {
+					stage->extPMUpsamplers[g].Reset();
+				}
+			}
+		}
 
-		// Accumulate ext PM input (needs to be processed at audio rate despite buffering)
-		for (int c = 0; c < numChannels; c++) {
-			float extpm = inputs[EXT_PM_INPUT].getPolyVoltage(c) / 10.0f;
-			for (int i = 0; i < oversampling; i++) {
-				extPMBuffers[c].push(extpm);
+		// Stage sync, linearly interpolated to the oversampled rate. That keeps each zero crossing
+		// at its exact sub-sample position for the oscillator to find. Only passed on for blocks
+		// it was connected for throughout, so unpatched voices skip edge detection entirely.
+		const bool syncConnected = inputs[SYNC_INPUT].isConnected();
+		syncBlockConnected = syncBlockConnected && syncConnected;
+		if (syncConnected) {
+			const float step = 1.0f / oversampling;
+			for (int c = 0; c < numChannels; c += 4) {
+				float_4 v = inputs[SYNC_INPUT].getPolyVoltageSimd<float_4>(c);
+				const float_4 last = float_4::load(&syncLast[c]);
+				v.store(&syncLast[c]);
+				const int groupEnd = std::min(c + 4, numChannels);
+				for (int i = 0; i < oversampling; i++) {
+					float lanes[4];
+					(last + (v - last) * (step * (i + 1))).store(lanes);
+					for (int ch = c; ch < groupEnd; ch++) {
+						syncStaging[ch * inputStride + blockPos * oversampling + i] = lanes[ch - c];
+					}
+				}
 			}
 		}
 
+		// Play back the previous block
+		const dsp::Frame<kMaxChannels * 2> &outputFrame = outputStaging[blockPos];
+		const float gain = fadeGain * 5.0f;
+		for (int c = 0; c < numChannels; c++) {
+			outputs[OSC_0_DEG_OUTPUT].setVoltage(outputFrame.samples[c * 2] * gain, c);
+			outputs[OSC_90_DEG_OUTPUT].setVoltage(outputFrame.samples[c * 2 + 1] * gain, c);
+		}
+
+		if (++blockPos < kBlockSize) return;
+		blockPos = 0;
+
+		const bool syncBlock = syncBlockConnected;
+		syncBlockConnected = true;
+		if (!syncConnected) {
+			std::fill(std::begin(syncLast), std::end(syncLast), 0.0f);
+		}
+
+		// Only timed while the governor is on, and not while a level change is in progress
+		const bool governed = CPU_BUDGETS[cpuBudget] > 0.0f || governor.GetLevel() > 0;
+		const bool timed = governed && fadeState == FADE_IDLE;
+		std::chrono::steady_clock::time_point blockStart;
+		if (timed) blockStart = std::chrono::steady_clock::now();
+
 		// Process kBlockSize * oversampling samples through the engine.
 		// This decimates the sample rate of inputs by kBlockSize.
-		if (outputBuffer.empty()) {
+		processBlockControls();
+		updateEngineChannels(numChannels);
+		updateWavetables(numChannels);
+		updateVoiceParams(numChannels);
+		if (scopeDue) publishScopeSnapshot();
 
-			// -- PM Ratio --
-			setRatioIndex(fmin(roundf(params[PM_RATIO_PARAM].getValue()), NUM_PM_RATIOS - 1));
+		dsp::Frame<kMaxChannels * 2> *outputFrames = oversampling == 1 ? outputStaging.Data() : stage->ovsStaging.Data();
 
-			// -- Algorithm Selection --
-			if (algo1Trigger.process(params[ALG1_PARAM].getValue())) {
-				if (onAlgoChanged) onAlgoChanged();
-				patch.pd_type[0] = static_cast<PDType>((patch.pd_type[0] + 1) % PDType::PD_TYPE_LAST); 
+		for (int c = 0; c < numChannels; c++) {
+
+			// -- Output --
+			dsp::Frame<2> ovsFrames[kMaxOvsBlockSize];
+			const float* sync = syncBlock ? &syncStaging[c * inputStride] : nullptr;
+			osc[c].ProcessBlock(patch, voices[c], &extPMStaging[c * inputStride], sync, (float *)ovsFrames, ovsBlockSize);
+			for (int i = 0; i < ovsBlockSize; i++) {
+				outputFrames[i].samples[c * 2] = ovsFrames[i].samples[0];
+				outputFrames[i].samples[c * 2 + 1] = ovsFrames[i].samples[1];
 			}
-			if (algo2Trigger.process(params[ALG2_PARAM].getValue())) {
-				if (onAlgoChanged) onAlgoChanged();
-				patch.pd_type[1] = static_cast<PDType>((patch.pd_type[1] + 1) % PDType::PD_TYPE_LAST); 
+		}
+
+		if (oversampling > 1) {
+			int inLen = ovsBlockSize;
+			int outLen = kBlockSize;
+			stage->outputSrc.process(outputFrames, &inLen, outputStaging.Data(), &outLen);
+			// The resampler may come up short while priming, pad with silence
+			for (int i = outLen; i < kBlockSize; i++) {
+				outputStaging[i] = {};
 			}
+			// Voices past the channel count the resampler was built for stay silent until
+			// the config for the new count arrives
+			for (int i = 0; i < outLen; i++) {
+				for (int s = activeConfig->numChannels * 2; s < numChannels * 2; s++) {
+					outputStaging[i].samples[s] = 0.0f;
+				}
+			}
+		}
 
-			// display
-			if (ratioMode) {
-				setRatioLEDs();
-			} else {
-				for (int i = 0; i < 8; i++) {
-					int active = (i % 2 == 0) ? static_cast<int>(patch.pd_type[0]) : static_cast<int>(patch.pd_type[1]);
-					float brightness = static_cast<int>(floorf(i / 2)) == active ? 1.0f : 0.0f;
-					lights[ALGO_LIGHT + i].setBrightness(brightness);
+		if (timed) {
+			const std::chrono::duration<float> elapsed = std::chrono::steady_clock::now() - blockStart;
+			governor.SetBudget(CPU_BUDGETS[cpuBudget]);
+			if (governor.Process(elapsed.count() * sampleRate / kBlockSize)) {
+				fadeState = FADE_OUT;
+			}
+		}
+	}
+
+	// Governor level and engine config changes are made click-free by briefly fading the outputs
+	// out, applying the change while silent, and fading back in once the engine has refilled.
+	void processFade() {
+		const float step = 1.0f / (kFadeTime * sampleRate);
+		switch (fadeState) {
+			case FADE_OUT:
+				fadeGain -= step;
+				if (fadeGain <= 0.0f) {
+					fadeGain = 0.0f;
+					reconfigureEngine();
+					// One block of latency plus one for the resampler to prime
+					fadeMuteSamples = kBlockSize * 2;
+					fadeState = FADE_MUTED;
 				}
+				break;
+			case FADE_MUTED:
+				if (--fadeMuteSamples <= 0) fadeState = FADE_IN;
+				break;
+			case FADE_IN:
+				fadeGain += step;
+				if (fadeGain >= 1.0f) {
+					fadeGain = 1.0f;
+					fadeState = FADE_IDLE;
+				}
+				break;
+			default:
+				break;
+		}
+	}
+
+	// Swaps in the pending engine config, if any, and selects its stage for the governor level.
+	// Only pointers change and buffers are cleared, configs are only ever built on the UI thread.
+	void reconfigureEngine() {
+		if (pendingConfig) {
+			// A user change of oversampling starts over at full quality, as does a new sample
+			// rate. A new channel count or ext PM quality keeps the governor where it is.
+			const bool restart = pendingConfig->numStages != activeConfig->numStages ||
+				pendingConfig->sampleRate != activeConfig->sampleRate;
+			configHandoff.Retire(activeConfig);
+			activeConfig = pendingConfig;
+			pendingConfig = nullptr;
+			if (restart) {
+				governor.Init(sampleRate / kBlockSize, activeConfig->numStages - 1);
 			}
+		}
+
+		stage = &activeConfig->stages[std::min(governor.GetOvsSteps(), activeConfig->numStages - 1)];
+		stage->Reset();
+		fastKernels = governor.GetFastKernels();
+		altOutDisabled = governor.GetAltOutDisabled();
+		extPMIdleSamples = kExtPMDrainSamples;
+		outputStaging.Clear();
+		blockPos = 0;
+
+		for (int c = 0; c < kMaxChannels; c++) {
+			osc[c].SetSampleRate(sampleRate * stage->oversampling);
+			osc[c].SetControlRate(sampleRate / kBlockSize);
+			osc[c].SetOutputRate(sampleRate);
+		}
 
-			// -- Routing + Windowing --
-			patch.routing = params[ROUTING_PARAM].getValue() > 0.0f ? Routing::ROUTING_PM_PRE : Routing::ROUTING_PM_POST;
-			patch.win_type = static_cast<WinType>(WinType::WIN_TYPE_LAST - 1 - params[WINDOW_PARAM].getValue());
+		int flags = 0;
+		if (governor.GetLevel() > 0) flags |= GOVERNOR_ACTIVE;
+		if (fastKernels) flags |= GOVERNOR_FAST_KERNELS;
+		if (altOutDisabled) flags |= GOVERNOR_ALT_OUT_OFF;
+		events.Push({MSG_GOVERNOR_STATUS, stage->oversampling, flags});
+	}
 
-			dsp::Frame<kMaxChannels * 2> outputFrames[ovsBlockSize];
+	// LFO engine: one frame per voice every kBlockSize samples, no oversampling or SRC.
+	// Output is linearly interpolated from the previous frame to the current one,
+	// which adds the same kBlockSize samples of latency as the audio rate engine.
+	void processControlRate(const int numChannels) {
 
+		// Rising zero crossings of sync restart the voice at its next frame
+		if (inputs[SYNC_INPUT].isConnected()) {
 			for (int c = 0; c < numChannels; c++) {
+				const float v = inputs[SYNC_INPUT].getPolyVoltage(c);
+				syncTriggered[c] = syncTriggered[c] || (syncLast[c] <= 0.0f && v > 0.0f);
+				syncLast[c] = v;
+			}
+		}
 
-				// -- pitch --
-				float octaves = params[TUNE_COARSE_PARAM].getValue();
-				octaves += inputs[PITCH_CV_INPUT].getVoltage(c);
-				patch.carrier_freq = exp2f(octaves) * kTuneMinFreq;
-
-				// -- PD Levels --
-				float pd1 = params[PD1_PARAM].getValue();
-				pd1 += (inputs[PD1_CV_INPUT].getPolyVoltage(c) / 10.0f) * params[PD1_ATTEN_PARAM].getValue();
-				patch.pd_amt[0] = rack::math::clamp(pd1, 0.0f, 1.0f);
-
-				float pd2 = params[PD2_PARAM].getValue();
-				pd2 += (inputs[PD2_CV_INPUT].getPolyVoltage(c) / 10.0f) * params[PD2_ATTEN_PARAM].getValue();
-				patch.pd_amt[1] = rack::math::clamp(pd2, 0.0f, 1.0f);
-
-				// -- PM --
-				float pm_amt = params[INT_PM_PARAM].getValue();
-				pm_amt += inputs[PM_CV_INPUT].getPolyVoltage(c) / 10.0f;
-				pm_amt = rack::math::clamp(pm_amt, 0.0f, 1.0f);
-				patch.pm_amt = pm_amt * pm_amt;
-
-				// -- Output --
-				dsp::Frame<2> ovsFrames[kMaxOvsBlockSize];
-				osc[c].ProcessBlock(patch, (float *)extPMBuffers[c].startData(), (float *)ovsFrames, ovsBlockSize);
-				extPMBuffers[c].startIncr(ovsBlockSize);
-				for (int i = 0; i < ovsBlockSize; i++) {
-					outputFrames[i].samples[c * 2] = ovsFrames[i].samples[0];
-					outputFrames[i].samples[c * 2 + 1] = ovsFrames[i].samples[1];
-				}
+		if (controlPhase == 0) {
+
+			processBlockControls();
+			updateVoiceParams(numChannels);
+			if (scopeDue) publishScopeSnapshot();
+
+			for (int c = 0; c < numChannels; c++) {
+				float extpm = inputs[EXT_PM_INPUT].getPolyVoltage(c) / 10.0f;
+				controlFrames[0].samples[c * 2] = controlFrames[1].samples[c * 2];
+				controlFrames[0].samples[c * 2 + 1] = controlFrames[1].samples[c * 2 + 1];
+				osc[c].ProcessControl(patch, voices[c], extpm, syncTriggered[c], &controlFrames[1].samples[c * 2]);
+				syncTriggered[c] = false;
 			}
+		}
 
-			if (oversampling == 1) {
-				for (int i = 0; i < kBlockSize; i++) {
-					outputBuffer.push(outputFrames[i]);
-				}
+		controlPhase++;
+		const float t = static_cast<float>(controlPhase) / kBlockSize;
+		for (int c = 0; c < numChannels; c++) {
+			float out = rack::math::crossfade(controlFrames[0].samples[c * 2], controlFrames[1].samples[c * 2], t);
+			float alt = rack::math::crossfade(controlFrames[0].samples[c * 2 + 1], controlFrames[1].samples[c * 2 + 1], t);
+			outputs[OSC_0_DEG_OUTPUT].setVoltage(out * 5.0f, c);
+			outputs[OSC_90_DEG_OUTPUT].setVoltage(alt * 5.0f, c);
+		}
+		if (controlPhase == kBlockSize) controlPhase = 0;
+	}
+
+	// Block rate: applies changes from the UI, reads all params once into the control snapshot
+	// and handles buttons, routing and windowing. Everything voice-independent is resolved here.
+	void processBlockControls() {
+
+		// -- UI Commands --
+		Message cmd;
+		while (commands.Pop(cmd)) {
+			applyCommand(cmd);
+		}
+
+		// -- Engine Config --
+		// Applied by reconfigureEngine(), at audio rate once the outputs have faded out
+		EngineConfig* next;
+		if (configHandoff.Take(next)) {
+			configHandoff.Retire(pendingConfig);
+			pendingConfig = next;
+		}
+		if (pendingConfig) {
+			if (freqRange == RANGE_LFO) {
+				reconfigureEngine();
 			} else {
-				outputSrc.setRates(static_cast<int>(sampleRate * oversampling), 
-									static_cast<int>(sampleRate));
-				outputSrc.setChannels(numChannels * 2);
-				int inLen = ovsBlockSize;
-				int outLen = kBlockSize;
-				outputSrc.process(outputFrames, &inLen, outputBuffer.endData(), &outLen);
-				outputBuffer.endIncr(outLen);
+				fadeState = FADE_OUT;
 			}
 		}
 
-		if (!outputBuffer.empty()) {
-			dsp::Frame<kMaxChannels * 2> outputFrame = outputBuffer.shift();
-			for (int c = 0; c < numChannels; c++) {
-				outputs[OSC_0_DEG_OUTPUT].setVoltage(outputFrame.samples[c * 2] * 5.0f, c);
-				outputs[OSC_90_DEG_OUTPUT].setVoltage(outputFrame.samples[c * 2 + 1] * 5.0f, c);
+		// -- PM Ratio --
+		const int ratioParam = std::min(static_cast<int>(roundf(params[PM_RATIO_PARAM].getValue())), static_cast<int>(NUM_PM_RATIOS) - 1);
+		if (static_cast<unsigned int>(ratioParam) != ratioIndex) {
+			applyRatioIndex(ratioParam);
+			events.Push({MSG_RATIO_INDEX, ratioParam, 0});
+		}
+
+		// -- Custom Warp Curve --
+		// Swapped in at a block boundary, the previous table goes back to the UI thread to be freed
+		SharedWarpTable* table;
+		if (warpTableHandoff.Take(table)) {
+			warpTableHandoff.Retire(warpTable);
+			warpTable = table;
+		}
+		patch.warp_table = warpTable ? warpTable->get() : nullptr;
+
+		// -- Algorithm Selection --
+		// Custom is only part of the button cycle while a curve is loaded. Without one, a patch
+		// loaded with Custom selected still steps from it to the first algorithm.
+		const int numAlgos = warpTable ? PDType::PD_TYPE_LAST : PDType::PD_TYPE_CUSTOM;
+		for (int ch = 0; ch < 2; ch++) {
+			if (algoTriggers[ch].process(params[ALG1_PARAM + ch].getValue())) {
+				const int next = patch.pd_type[ch] + 1;
+				patch.pd_type[ch] = static_cast<PDType>(next < numAlgos ? next : 0);
+				events.Push({MSG_WARP_ALGORITHM, ch, patch.pd_type[ch]});
 			}
 		}
-		outputs[OSC_0_DEG_OUTPUT].setChannels(numChannels);
-		outputs[OSC_90_DEG_OUTPUT].setChannels(numChannels);
+
+		// -- Routing + Windowing --
+		patch.routing = params[ROUTING_PARAM].getValue() > 0.0f ? Routing::ROUTING_PM_PRE : Routing::ROUTING_PM_POST;
+		patch.win_type = static_cast<WinType>(WinType::WIN_TYPE_LAST - 1 - params[WINDOW_PARAM].getValue());
+
+		// -- Quality --
+		// The aux output is skipped entirely when unpatched
+		patch.kernel_quality = fastKernels ? KernelQuality::KERNEL_QUALITY_FAST : KernelQuality::KERNEL_QUALITY_HIGH;
+		patch.alt_out_enabled = outputs[OSC_90_DEG_OUTPUT].isConnected() && !altOutDisabled;
+
+		// -- Voice-independent parts of the per-voice controls --
+		if (freqRange == RANGE_LFO) {
+			controls.tuneOctaves = params[TUNE_COARSE_PARAM].getValue() * kLfoTuneScale;
+			controls.minFreq = kLfoMinFreq;
+		} else {
+			controls.tuneOctaves = params[TUNE_COARSE_PARAM].getValue();
+			controls.minFreq = kTuneMinFreq;
+		}
+		controls.pd[0] = params[PD1_PARAM].getValue();
+		controls.pd[1] = params[PD2_PARAM].getValue();
+		controls.pdAtten[0] = params[PD1_ATTEN_PARAM].getValue() / 10.0f;
+		controls.pdAtten[1] = params[PD2_ATTEN_PARAM].getValue() / 10.0f;
+		controls.pm = params[INT_PM_PARAM].getValue();
+	}
+
+	// UI rate: indicator LEDs and display publishing
+	void processUIRate() {
+		if (ratioMode) {
+			setRatioLEDs();
+		} else {
+			// Custom lights all four LEDs of its side
+			const int active[2] = {static_cast<int>(patch.pd_type[0]), static_cast<int>(patch.pd_type[1])};
+			for (int i = 0; i < 8; i++) {
+				const bool on = i / 2 == active[i % 2] || active[i % 2] == PDType::PD_TYPE_CUSTOM;
+				lights[ALGO_LIGHT + i].setBrightness(on ? 1.0f : 0.0f);
+			}
+		}
+
+		// Picked up by the next block, once a voice patch is available
+		scopeDue = displayEnabled;
+
+		// Rack sets flush-to-zero on its engine threads. The core doesn't depend on it, but
+		// it's checked once so a host that doesn't set it shows up in the log.
+		if (!denormalsChecked) {
+			denormalsChecked = true;
+			if (!infrasonic::DenormalsFlushed()) {
+				events.Push({MSG_DENORMALS, 0, 0});
+			}
+		}
+	}
+
+	// Never blocks: if the UI hasn't caught up the snapshot is simply dropped
+	void publishScopeSnapshot() {
+		infrasonic::WarpScopeSnapshot snapshot;
+		snapshot.patch = patch;
+		snapshot.voice = voices[0];
+		scopeQueue.Push(snapshot);
+		scopeDue = false;
+	}
+
+	// The output resampler is built for a channel count on the UI thread, with the rest of the
+	// config. A new count is requested here and swapped in behind a fade like any config change.
+	void updateEngineChannels(const int numChannels) {
+		if (numChannels != engineChannelsRequested && events.Push({MSG_ENGINE_CHANNELS, numChannels, 0})) {
+			engineChannelsRequested = numChannels;
+		}
+	}
+
+	// Wavetables are only allocated while the wavetable engine is on, one per voice in use, by
+	// the UI thread on request. A bank for more voices takes over the tables of the one before.
+	void updateWavetables(const int numChannels) {
+		WavetableBank* bank;
+		if (wavetableHandoff.Take(bank)) {
+			for (int c = 0; c < kMaxChannels; c++)
+				osc[c].SetWavetable(bank && c < bank->numVoices ? &bank->tables[c] : nullptr);
+			wavetableHandoff.Retire(wavetableBank);
+			wavetableBank = bank;
+		}
+
+		// Grows with the voice count and is freed when the engine is turned off, retried
+		// on the next block if the event queue is full
+		const int needed = patch.wavetable_enabled ? numChannels : 0;
+		const bool grow = needed > wavetableVoicesRequested;
+		const bool release = needed == 0 && wavetableVoicesRequested > 0;
+		if ((grow || release) && events.Push({MSG_WAVETABLE_VOICES, needed, 0})) {
+			wavetableVoicesRequested = needed;
+		}
+	}
+
+	// Per-voice controls: pitch, warp amounts and PM level for all voices from the control snapshot,
+	// one SIMD group of 4 channels at a time, transposed into the packed per-voice params
+	void updateVoiceParams(const int numChannels) {
+		static_assert(sizeof(VoiceParams) == 4 * sizeof(float), "VoiceParams must pack into one float_4");
+
+		for (int c = 0; c < numChannels; c += 4) {
+
+			// -- pitch --
+			float_4 octaves = controls.tuneOctaves + inputs[PITCH_CV_INPUT].getVoltageSimd<float_4>(c);
+			float_4 freq = dsp::exp2_taylor5(octaves) * controls.minFreq;
+
+			// -- PD Levels --
+			float_4 pd1 = controls.pd[0] + inputs[PD1_CV_INPUT].getPolyVoltageSimd<float_4>(c) * controls.pdAtten[0];
+			pd1 = clamp(pd1, 0.0f, 1.0f);
+
+			float_4 pd2 = controls.pd[1] + inputs[PD2_CV_INPUT].getPolyVoltageSimd<float_4>(c) * controls.pdAtten[1];
+			pd2 = clamp(pd2, 0.0f, 1.0f);
+
+			// -- PM --
+			float_4 pm = controls.pm + inputs[PM_CV_INPUT].getPolyVoltageSimd<float_4>(c) / 10.0f;
+			pm = clamp(pm, 0.0f, 1.0f);
+			pm *= pm;
+
+			// Rows are now {carrier_freq, pd_amt[0], pd_amt[1], pm_amt} for voices c to c + 3
+			_MM_TRANSPOSE4_PS(freq.v, pd1.v, pd2.v, pm.v);
+			freq.store(&voices[c].carrier_freq);
+			pd1.store(&voices[c + 1].carrier_freq);
+			pd2.store(&voices[c + 2].carrier_freq);
+			pm.store(&voices[c + 3].carrier_freq);
+		}
 	}
 
 	void setRatioLEDs() {
@@ -269,72 +752,477 @@ struct WarpCore : Module {
 		}
 	}
 
+	// Setters and getters below are for the UI thread. Changes reach the audio thread as
+	// commands applied at the next block boundary, and getters read the UI copy in `settings`.
+
 	unsigned int getRatioIndex() const {
-		return ratioIndex;
+		return settings.ratioIndex;
 	}
 
 	void setRatioIndex(unsigned int idx) {
 		if (idx >= NUM_PM_RATIOS) return;
-		ratioIndex = idx;
-		float num = static_cast<float>(PM_RATIOS[idx][0]);
-		float denom = static_cast<float>(PM_RATIOS[idx][1]);
-		patch.pm_ratio = num/denom;
+		settings.ratioIndex = idx;
+		sendCommand({MSG_RATIO_INDEX, static_cast<int>(idx), 0});
 	}
 
 	void setWarpAlgorithm(int ch, int idx) {
-		assert(ch < 2 && idx < PDType::PD_TYPE_LAST);
-		auto pdType = static_cast<PDType>(idx);
-		patch.pd_type[ch] = pdType;
+		assert(ch < 2);
+		if (idx < 0 || idx >= PDType::PD_TYPE_LAST) return;
+		settings.pdType[ch] = idx;
+		sendCommand({MSG_WARP_ALGORITHM, ch, idx});
 	}
 
 	int getWarpAlgorithm(int ch) const {
 		assert(ch < 2);
-		return static_cast<int>(patch.pd_type[ch]);
+		return settings.pdType[ch];
+	}
+
+	int getNumWarpAlgorithms() const {
+		return warpTableUI ? PDType::PD_TYPE_LAST : PDType::PD_TYPE_CUSTOM;
+	}
+
+	// Looks the table up (or builds it) on the calling (UI) thread and hands a reference to the
+	// audio thread, which swaps it in at the next block. Instances with the same curve share one
+	// table, and the last reference is always released here. An empty curve clears it.
+	bool setWarpCurve(const std::vector<WarpTable::Point>& points) {
+		SharedWarpTable table;
+		if (!points.empty()) {
+			table = infrasonic::SharedTables::GetWarpTable(points.data(), points.size());
+			if (!table) {
+				return false;
+			}
+		}
+
+		if (!warpTableHandoff.Publish(table ? new SharedWarpTable(table) : nullptr)) {
+			return false;
+		}
+		warpTableUI = table;
+		return true;
+	}
+
+	bool loadWarpCurve(const std::string& path) {
+		std::ifstream file(path);
+		std::vector<WarpTable::Point> points;
+		if (!file || !parseWarpCurve(file, points)) {
+			WARN("Could not read warp curve from %s", path.c_str());
+			return false;
+		}
+		return setWarpCurve(points);
 	}
 
 	void setAltOutputType(int idx) {
-		patch.alt_out_type  = static_cast<OutType>(idx);
+		if (idx < 0 || idx >= OutType::OUT_TYPE_LAST) return;
+		settings.altOutType = idx;
+		sendCommand({MSG_ALT_OUTPUT_TYPE, idx, 0});
 	}
 
 	int getAltOutputType() const {
-		return static_cast<int>(patch.alt_out_type);
+		return settings.altOutType;
 	}
 
 	unsigned int getOversampling() const {
-		return srConfig.oversampling;
+		return settings.oversampling;
+	}
+
+	int getCpuBudget() const {
+		return settings.cpuBudget;
+	}
+
+	void setCpuBudget(int idx) {
+		if (idx < 0 || idx >= static_cast<int>(NUM_CPU_BUDGETS)) return;
+		settings.cpuBudget = idx;
+		sendCommand({MSG_CPU_BUDGET, idx, 0});
+	}
+
+	bool getPhaseLock() const {
+		return settings.phaseLock;
+	}
+
+	void setPhaseLock(bool enabled) {
+		settings.phaseLock = enabled;
+		sendCommand({MSG_PHASE_LOCK, enabled, 0});
+	}
+
+	bool getWavetable() const {
+		return settings.wavetable;
+	}
+
+	void setWavetable(bool enabled) {
+		settings.wavetable = enabled;
+		sendCommand({MSG_WAVETABLE, enabled, 0});
+	}
+
+	// What the governor currently has turned down, for the context menu
+	std::string getGovernorStatus() const {
+		if (!(governorStatus.flags & GOVERNOR_ACTIVE)) return "Full quality";
+		std::string status = string::f("%dx oversampling", governorStatus.oversampling);
+		if (governorStatus.flags & GOVERNOR_FAST_KERNELS) status += ", fast math";
+		if (governorStatus.flags & GOVERNOR_ALT_OUT_OFF) status += ", aux off";
+		return status;
 	}
 
 	void setOversampling(unsigned int ovs) {
-		srConfig.oversampling = ovs;
-		needsSampleRateUpdate = true;
+		if (ovs < 1 || ovs > Upsampler::kMaxFactor || (ovs & (ovs - 1)) != 0) return;
+		std::lock_guard<std::mutex> lock(configMutex);
+		settings.oversampling = ovs;
+		publishEngineConfig();
+	}
+
+	int getExtPMQuality() const {
+		return settings.extPMQuality;
+	}
+
+	void setExtPMQuality(int idx) {
+		if (idx < 0 || idx >= static_cast<int>(NUM_EXT_PM_QUALITIES)) return;
+		std::lock_guard<std::mutex> lock(configMutex);
+		settings.extPMQuality = idx;
+		publishEngineConfig();
+	}
+
+	int getFreqRange() const {
+		return settings.freqRange;
+	}
+
+	void setFreqRange(int idx) {
+		if (idx < 0 || idx >= RANGE_LAST) return;
+		settings.freqRange = idx;
+		sendCommand({MSG_FREQ_RANGE, idx, 0});
+
+		// Keep the knob tooltip in Hz for the active range
+		ParamQuantity* tuneQuantity = paramQuantities[TUNE_COARSE_PARAM];
+		if (idx == RANGE_LFO) {
+			tuneQuantity->displayBase = exp2f(kLfoTuneScale);
+			tuneQuantity->displayMultiplier = kLfoMinFreq;
+		} else {
+			tuneQuantity->displayBase = 2.0f;
+			tuneQuantity->displayMultiplier = kTuneMinFreq;
+		}
+	}
+
+	// Applies changes reported by the audio thread to the UI copy. Called from the widget
+	// every frame, and before saving in case there is no widget.
+	void pollEvents() {
+		Message event;
+		while (events.Pop(event)) {
+			switch (event.type) {
+				case MSG_WARP_ALGORITHM:
+					settings.pdType[event.a] = event.b;
+					if (onAlgoChanged) onAlgoChanged();
+					break;
+				case MSG_RATIO_INDEX:
+					settings.ratioIndex = event.a;
+					break;
+				case MSG_GOVERNOR_STATUS:
+					governorStatus.oversampling = event.a;
+					governorStatus.flags = event.b;
+					break;
+				case MSG_DENORMALS:
+					WARN("Warp Core is running on a thread without flush-to-zero, denormal math may be slow");
+					break;
+				case MSG_ENGINE_CHANNELS: {
+					std::lock_guard<std::mutex> lock(configMutex);
+					engineChannels = event.a;
+					publishEngineConfig();
+					break;
+				}
+				case MSG_WAVETABLE_VOICES:
+					if (!wavetableHandoff.Publish(event.a > 0 ? new WavetableBank(event.a) : nullptr)) {
+						WARN("Warp Core audio thread is not taking wavetables, playing without them");
+					}
+					break;
+				default:
+					break;
+			}
+		}
+		// Frees the bank the audio thread let go of, without waiting for the next one
+		wavetableHandoff.Collect();
 	}
 
 	private:
 		static const int kMaxChannels = rack::engine::PORT_MAX_CHANNELS;
 		static const int kBlockSize = 8;
 		static const int kMaxOvsBlockSize = kBlockSize * 16;
-		static_assert(kBlockSize % 4 == 0, "Block size must be a multiple of 4 for SIMD");
+		static const int kFloatsPerCacheLine = 64 / sizeof(float);
+		static const int kNumSimdGroups = kMaxChannels / vfloat::size;
+		static_assert(kBlockSize % vfloat::size == 0, "Block size must be a multiple of the SIMD width");
 
 		static constexpr float kTuneMinFreq = 32.7f; // C1
 		static constexpr float kTuneNumOctaves = 5.0f;
 
+		// LFO range spans kLfoMinFreq to 30 Hz over the same knob travel
+		static constexpr float kLfoMinFreq = 0.01f;
+		static constexpr float kLfoTuneScale = 2.3099f; // log2(30 / 0.01) / kTuneNumOctaves
+
 		infrasonic::PhaseDistortionOscillator::Patch patch;
 		infrasonic::PhaseDistortionOscillator osc[kMaxChannels];
+		alignas(16) VoiceParams voices[kMaxChannels];
+
+		dsp::BooleanTrigger algoTriggers[2];
+
+		// Output for one block at the engine rate, whatever the oversampling
+		infrasonic::AlignedBuffer<dsp::Frame<kMaxChannels * 2>> outputStaging;
+		int blockPos = 0;
+
+		// UI rate tier, ~94 Hz at 48 kHz
+		static const int kUIDivision = 512;
+		dsp::ClockDivider uiDivider;
+		bool scopeDue = false;
+		bool denormalsChecked = false;
+
+		// Params read once per block
+		struct ControlSnapshot {
+			float tuneOctaves = 0.0f;
+			float minFreq = kTuneMinFreq;
+			float pd[2] = {};
+			float pdAtten[2] = {}; // pre-scaled from volts
+			float pm = 0.0f;
+		};
+		ControlSnapshot controls;
+
+		// Custom warp curve in use by the audio thread, and the handoff from the UI thread
+		SharedWarpTable* warpTable = nullptr;
+		infrasonic::Handoff<SharedWarpTable> warpTableHandoff;
+
+		// Wavetables for the first numVoices voices, in use by the audio thread, and the handoff
+		// from the UI thread. About 33 KB per voice.
+		struct WavetableBank {
+			int numVoices;
+			std::unique_ptr<infrasonic::MipmapWavetable[]> tables;
+
+			explicit WavetableBank(const int voices)
+				: numVoices(voices), tables(new infrasonic::MipmapWavetable[voices]) {
+				for (int c = 0; c < numVoices; c++)
+					tables[c].Init();
+			}
+		};
+		WavetableBank* wavetableBank = nullptr;
+		int wavetableVoicesRequested = 0;
+		infrasonic::Handoff<WavetableBank> wavetableHandoff;
+
+		// Previous and current frames of the control rate engine
+		dsp::Frame<kMaxChannels * 2> controlFrames[2] = {};
+		int controlPhase = 0;
+
+		// Samples since ext PM was last patched, up to the upsampler history length plus a block.
+		// The extra block means the staging is only cleared once the block being filled holds
+		// nothing but silence, so the unplug tail is always played out in full.
+		static const int kExtPMDrainSamples = Upsampler::kMaxTapsPerPhase + kBlockSize;
+		int extPMIdleSamples = kExtPMDrainSamples;
+
+		// Hard sync, last input voltage per channel and edges waiting for the next control frame
+		float syncLast[kMaxChannels] = {};
+		bool syncTriggered[kMaxChannels] = {};
+		bool syncBlockConnected = true;
+
+		// Everything the audio rate engine needs at one oversampling factor. Built on the UI
+		// thread, since it allocates and designs filters.
+		struct OvsStage {
+			int oversampling = 1;
+			// Ext PM and sync are channel-major with each channel starting on a cache line
+			int inputStride = 0;
+			infrasonic::AlignedBuffer<float> extPMStaging;
+			infrasonic::AlignedBuffer<float> syncStaging;
+			infrasonic::AlignedBuffer<dsp::Frame<kMaxChannels * 2>> ovsStaging;
+			Upsampler extPMUpsamplers[kNumSimdGroups];
+			dsp::SampleRateConverter<kMaxChannels * 2> outputSrc;
+
+			void Init(float sampleRate, int factor, size_t extPMTaps, int numChannels) {
+				oversampling = factor;
+				const int ovsBlockSize = kBlockSize * factor;
+				inputStride = (ovsBlockSize + kFloatsPerCacheLine - 1) / kFloatsPerCacheLine * kFloatsPerCacheLine;
+				extPMStaging.Resize(kMaxChannels * inputStride);
+				syncStaging.Resize(kMaxChannels * inputStride);
+				ovsStaging.Resize(factor > 1 ? ovsBlockSize : 0);
+				for (int g = 0; g < kNumSimdGroups; g++) {
+					extPMUpsamplers[g].Init(factor, extPMTaps);
+				}
+				outputSrc.setRates(static_cast<int>(sampleRate * factor), static_cast<int>(sampleRate));
+				outputSrc.setChannels(numChannels * 2);
+			}
 
-		dsp::BooleanTrigger algo1Trigger, algo2Trigger;
-		dsp::SampleRateConverter<kMaxChannels * 2> outputSrc;
-		dsp::DoubleRingBuffer<float, 256> extPMBuffers[kMaxChannels];
-		dsp::DoubleRingBuffer<dsp::Frame<kMaxChannels * 2>, 256> outputBuffer;
+			void Reset() {
+				extPMStaging.Clear();
+				syncStaging.Clear();
+				ovsStaging.Clear();
+				for (int g = 0; g < kNumSimdGroups; g++) {
+					extPMUpsamplers[g].Reset();
+				}
+				// Clears the filter history without reallocating, so a stage the governor
+				// steps back to starts clean
+				if (outputSrc.st) speex_resampler_reset_mem(outputSrc.st);
+			}
+		};
 
-		unsigned int ratioIndex = 3;
+		// Engine configuration chosen from the UI: a stage for the configured oversampling and
+		// one for each halving the governor can step down to, so that governor changes never
+		// allocate. At 16x this is about 100 KB per instance.
+		static const int kMaxOvsStages = 5; // 16x down to 1x
+		struct EngineConfig {
+			float sampleRate = 0.0f;
+			unsigned int oversampling = 4;
+			int extPMQuality = 2;
+			int numChannels = 1;
+			int numStages = 0;
+			OvsStage stages[kMaxOvsStages];
+
+			void Build(float rate) {
+				sampleRate = rate;
+				numStages = 0;
+				for (unsigned int factor = oversampling; factor > 0; factor >>= 1) {
+					stages[numStages++].Init(rate, factor, EXT_PM_TAPS[extPMQuality], numChannels);
+				}
+			}
+		};
 
-		struct SampleRateConfig {
-			float sampleRate = 48000.0f;
+		// Config and stage in use by the audio thread, and one waiting for the outputs to fade out
+		EngineConfig* activeConfig = nullptr;
+		EngineConfig* pendingConfig = nullptr;
+		OvsStage* stage = nullptr;
+		infrasonic::Handoff<EngineConfig> configHandoff;
+
+		// Governor steps applied with the stage, so they only change while the outputs are muted
+		bool fastKernels = false;
+		bool altOutDisabled = false;
+
+		// Messages between the UI and audio threads, commands go to the audio thread and events
+		// come back from it. Commands are applied at block boundaries, in order.
+		enum MessageType {
+			MSG_WARP_ALGORITHM,   // a: side, b: algorithm
+			MSG_ALT_OUTPUT_TYPE,  // a: type
+			MSG_RATIO_INDEX,      // a: index
+			MSG_FREQ_RANGE,       // a: range
+			MSG_CPU_BUDGET,       // a: budget index
+			MSG_PHASE_LOCK,       // a: enabled
+			MSG_WAVETABLE,        // a: enabled
+			MSG_GOVERNOR_STATUS,  // a: oversampling in use, b: GovernorFlags
+			MSG_DENORMALS,        // denormals are not flushed on the audio thread
+			MSG_WAVETABLE_VOICES, // a: voices that need a wavetable, 0 frees them all
+			MSG_ENGINE_CHANNELS   // a: channel count the engine config needs
+		};
+		struct Message {
+			MessageType type;
+			int a;
+			int b;
+		};
+		infrasonic::SpscQueue<Message, 64> commands;
+		infrasonic::SpscQueue<Message, 64> events;
+
+		enum GovernorFlags {
+			GOVERNOR_ACTIVE = 1 << 0,
+			GOVERNOR_FAST_KERNELS = 1 << 1,
+			GOVERNOR_ALT_OUT_OFF = 1 << 2
+		};
+
+		// UI thread copy of the settings, read by the context menu and saved with the patch
+		struct Settings {
+			int pdType[2] = {PDType::PD_TYPE_BEND, PDType::PD_TYPE_SYNC};
+			int altOutType = OutType::OUT_TYPE_90;
+			unsigned int ratioIndex = 3;
+			int freqRange = RANGE_AUDIO;
 			unsigned int oversampling = 4;
+			int extPMQuality = 2;
+			int cpuBudget = 0;
+			bool phaseLock = true;
+			bool wavetable = true;
+		};
+		Settings settings;
+
+		struct GovernorStatus {
+			int oversampling = 4;
+			int flags = 0;
+		};
+		GovernorStatus governorStatus;
+
+		// Engine rate and channel count configs are built for, and what they were built from,
+		// guarded by configMutex since a rate change may come from another thread than the UI
+		std::mutex configMutex;
+		float engineSampleRate = 48000.0f;
+		int engineChannels = 1;
+
+		// Channel count the audio thread last asked for a config for
+		int engineChannelsRequested = 1;
+
+		// Audio thread state, only ever changed by commands, params or the governor
+		float sampleRate = 48000.0f;
+		FreqRange freqRange = RANGE_AUDIO;
+		unsigned int ratioIndex = 3;
+		int cpuBudget = 0;
+
+		// Output fade around governor level and engine config changes
+		enum FadeState {
+			FADE_IDLE,
+			FADE_OUT,
+			FADE_MUTED,
+			FADE_IN
 		};
-		SampleRateConfig srConfig;
+		static constexpr float kFadeTime = 0.005f;
+		FadeState fadeState = FADE_IDLE;
+		float fadeGain = 1.0f;
+		int fadeMuteSamples = 0;
+
+		infrasonic::QualityGovernor governor;
+
+		// Audio thread
+		void applyCommand(const Message& cmd) {
+			switch (cmd.type) {
+				case MSG_WARP_ALGORITHM:
+					patch.pd_type[cmd.a] = static_cast<PDType>(cmd.b);
+					break;
+				case MSG_ALT_OUTPUT_TYPE:
+					patch.alt_out_type = static_cast<OutType>(cmd.a);
+					break;
+				case MSG_RATIO_INDEX:
+					applyRatioIndex(cmd.a);
+					break;
+				case MSG_FREQ_RANGE:
+					freqRange = static_cast<FreqRange>(cmd.a);
+					controlPhase = 0;
+					break;
+				case MSG_CPU_BUDGET:
+					cpuBudget = cmd.a;
+					break;
+				case MSG_PHASE_LOCK:
+					patch.phase_lock = cmd.a != 0;
+					break;
+				case MSG_WAVETABLE:
+					patch.wavetable_enabled = cmd.a != 0;
+					break;
+				default:
+					break;
+			}
+		}
+
+		// Audio thread
+		void applyRatioIndex(unsigned int idx) {
+			ratioIndex = idx;
+			float num = static_cast<float>(PM_RATIOS[idx][0]);
+			float denom = static_cast<float>(PM_RATIOS[idx][1]);
+			patch.pm_ratio = num/denom;
+		}
 
-		std::atomic_bool needsSampleRateUpdate = ATOMIC_VAR_INIT(false);
+		// UI thread. Only fails if the audio thread has stopped taking commands.
+		void sendCommand(const Message& cmd) {
+			if (!commands.Push(cmd)) {
+				WARN("Warp Core command queue is full, dropping a change");
+			}
+		}
+
+		// UI thread, with configMutex held
+		EngineConfig* buildEngineConfig() const {
+			EngineConfig* next = new EngineConfig();
+			next->oversampling = settings.oversampling;
+			next->extPMQuality = settings.extPMQuality;
+			next->numChannels = engineChannels;
+			next->Build(engineSampleRate);
+			return next;
+		}
+
+		// UI thread, with configMutex held
+		void publishEngineConfig() {
+			if (!configHandoff.Publish(buildEngineConfig())) {
+				WARN("Warp Core engine config queue is full, dropping a change");
+			}
+		}
 };
 
 
@@ -350,7 +1238,28 @@ static const std::string warpAlgoLabels[] = {
 	"Bend",
 	"Sync",
 	"Pinch",
-	"Fold"
+	"Fold",
+	"Custom"
+};
+
+static const std::string freqRangeLabels[] = {
+	"Audio (C1 - C6)",
+	"LFO (0.01 - 30 Hz)"
+};
+
+static const std::string extPMQualityLabels[] = {
+	"Off (Hold)",
+	"Low",
+	"Medium",
+	"High"
+};
+
+static const std::string cpuBudgetLabels[] = {
+	"Off",
+	"2%",
+	"5%",
+	"10%",
+	"20%"
 };
 
 static const std::string outTypeLabels[] = {
@@ -395,10 +1304,19 @@ struct WarpCoreWidget : ModuleWidget {
 		addInput(createInputCentered<PJ301MPort>(mm2px(Vec(8.454, 110.029)), module, WarpCore::PITCH_CV_INPUT));
 		addInput(createInputCentered<PJ301MPort>(mm2px(Vec(19.458, 110.029)), module, WarpCore::PM_CV_INPUT));
 		addInput(createInputCentered<PJ301MPort>(mm2px(Vec(30.461, 110.029)), module, WarpCore::EXT_PM_INPUT));
+		addInput(createInputCentered<PJ301MPort>(mm2px(Vec(30.48, 97.103)), module, WarpCore::SYNC_INPUT));
 
 		addOutput(createOutputCentered<PJ301MPort>(mm2px(Vec(41.465, 110.029)), module, WarpCore::OSC_0_DEG_OUTPUT));
 		addOutput(createOutputCentered<PJ301MPort>(mm2px(Vec(52.468, 110.029)), module, WarpCore::OSC_90_DEG_OUTPUT));
 
+		auto* scope = createWidgetCentered<infrasonic::WarpScope>(mm2px(Vec(30.48, 25.45)));
+		if (module) {
+			scope->queue = &module->scopeQueue;
+			scope->enabled = &module->displayEnabled;
+			scope->warpTable = &module->warpTableUI;
+		}
+		addChild(scope);
+
 		using infrasonic::BlueRedLight;
 		addChild(createLightCentered<MediumLight<BlueRedLight>>(mm2px(Vec(30.48, 47.25)), module, WarpCore::ALGO_LIGHT + 0 * 2));
 		addChild(createLightCentered<MediumLight<BlueRedLight>>(mm2px(Vec(30.48, 52.295)), module, WarpCore::ALGO_LIGHT + 1 * 2));
@@ -406,6 +1324,12 @@ struct WarpCoreWidget : ModuleWidget {
 		addChild(createLightCentered<MediumLight<BlueRedLight>>(mm2px(Vec(30.48, 62.334)), module, WarpCore::ALGO_LIGHT + 3 * 2));
 	}
 
+	void step() override {
+		WarpCore* module = dynamic_cast<WarpCore*>(this->module);
+		if (module) module->pollEvents();
+		ModuleWidget::step();
+	}
+
 	void appendContextMenu(Menu* menu) override {
 		WarpCore* module = dynamic_cast<WarpCore*>(this->module);
 		
@@ -416,9 +1340,14 @@ struct WarpCoreWidget : ModuleWidget {
 			[=](bool val) { this->setRatioMode(val); }
 		));
 
+		menu->addChild(createBoolMenuItem("Show Display", "",
+			[=]() { return module->displayEnabled.load(); },
+			[=](bool val) { module->displayEnabled = val; }
+		));
+
 		menu->addChild(new MenuSeparator);
 
-		std::vector<std::string> warpLabels(std::begin(warpAlgoLabels), std::end(warpAlgoLabels));
+		std::vector<std::string> warpLabels(warpAlgoLabels, warpAlgoLabels + module->getNumWarpAlgorithms());
 		menu->addChild(createIndexSubmenuItem("Warp A Algorithm", warpLabels,
 			[=]() { return module->getWarpAlgorithm(0); },
 			[=](int idx) { module->setWarpAlgorithm(0, idx); } 
@@ -429,6 +1358,29 @@ struct WarpCoreWidget : ModuleWidget {
 			[=](int idx) { module->setWarpAlgorithm(1, idx); } 
 		));
 
+		menu->addChild(createMenuItem("Load Custom Warp Curve...", "", [=]() {
+			osdialog_filters* filters = osdialog_filters_parse("Warp curve (.txt .csv):txt,csv");
+			char* pathC = osdialog_file(OSDIALOG_OPEN, NULL, NULL, filters);
+			osdialog_filters_free(filters);
+			if (!pathC) return;
+			std::string path = pathC;
+			std::free(pathC);
+			if (!module->loadWarpCurve(path)) {
+				osdialog_message(OSDIALOG_WARNING, OSDIALOG_OK, "Could not load warp curve. Expected 2 to 256 lines of \"x y\" or \"y\" values from 0 to 1, \"x y\" points in any order.");
+			}
+		}));
+
+		if (module->warpTableUI) {
+			menu->addChild(createMenuItem("Clear Custom Warp Curve", "", [=]() {
+				module->setWarpCurve({});
+			}));
+		}
+
+		menu->addChild(createBoolMenuItem("Phase-Lock PM and Sub", "",
+			[=]() { return module->getPhaseLock(); },
+			[=](bool val) { module->setPhaseLock(val); }
+		));
+
 		std::vector<std::string> outLabels(std::begin(outTypeLabels), std::end(outTypeLabels));
 		menu->addChild(createIndexSubmenuItem("Auxiliary Output Mode", outLabels,
 			[=]() { return module->getAltOutputType(); },
@@ -437,11 +1389,38 @@ struct WarpCoreWidget : ModuleWidget {
 
 		menu->addChild(new MenuSeparator);
 
+		std::vector<std::string> rangeLabels(std::begin(freqRangeLabels), std::end(freqRangeLabels));
+		menu->addChild(createIndexSubmenuItem("Frequency Range", rangeLabels,
+			[=]() { return module->getFreqRange(); },
+			[=](int idx) { module->setFreqRange(idx); }
+		));
+
 		std::vector<std::string> ovsLabels(std::begin(oversamplingLabels), std::end(oversamplingLabels));
 		menu->addChild(createIndexSubmenuItem("Oversampling", ovsLabels,
 			[=]() { return log2f(module->getOversampling()); },
 			[=](int idx) { module->setOversampling(exp2f(idx)); }
 		));
+
+		menu->addChild(createBoolMenuItem("Wavetables for High Voices", "",
+			[=]() { return module->getWavetable(); },
+			[=](bool val) { module->setWavetable(val); }
+		));
+
+		std::vector<std::string> extPMLabels(std::begin(extPMQualityLabels), std::end(extPMQualityLabels));
+		menu->addChild(createIndexSubmenuItem("EXT PM Interpolation", extPMLabels,
+			[=]() { return module->getExtPMQuality(); },
+			[=](int idx) { module->setExtPMQuality(idx); }
+		));
+
+		std::vector<std::string> budgetLabels(std::begin(cpuBudgetLabels), std::end(cpuBudgetLabels));
+		menu->addChild(createIndexSubmenuItem("CPU Governor Budget", budgetLabels,
+			[=]() { return module->getCpuBudget(); },
+			[=](int idx) { module->setCpuBudget(idx); }
+		));
+
+		if (module->getCpuBudget() > 0) {
+			menu->addChild(createMenuLabel("Governor: " + module->getGovernorStatus()));
+		}
 	}
 
 	bool getRatioMode() const {
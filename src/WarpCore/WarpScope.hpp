@@ -0,0 +1,99 @@
+#pragma once
+#include "../plugin.hpp"
+#include "../dsp/PDO.hpp"
+#include "../dsp/spsc_queue.hpp"
+
+/// Panel display of the warped waveform and phase transfer curve
+
+namespace infrasonic {
+
+// Decimated state published by the audio thread a few times per UI frame
+struct WarpScopeSnapshot {
+	PhaseDistortionOscillator::Patch patch;
+	PhaseDistortionOscillator::VoiceParams voice;
+};
+
+using WarpScopeQueue = SpscQueue<WarpScopeSnapshot, 8>;
+
+struct WarpScope : widget::TransparentWidget {
+
+	static const int kNumPoints = 96;
+
+	WarpScopeQueue* queue = nullptr;
+	const std::atomic_bool* enabled = nullptr;
+	// Curve used for display, so a snapshot never refers to a table the UI thread has since freed
+	const std::shared_ptr<const WarpTable>* warpTable = nullptr;
+
+	WarpScope() {
+		box.size = mm2px(Vec(18.4f, 18.4f));
+	}
+
+	void step() override {
+		// Keep only the latest snapshot, all curve evaluation happens here on the UI thread
+		WarpScopeSnapshot snapshot;
+		bool received = false;
+		while (queue && queue->Pop(snapshot)) {
+			received = true;
+		}
+		if (received) {
+			if (warpTable) snapshot.patch.warp_table = warpTable->get();
+			for (int i = 0; i < kNumPoints; i++) {
+				float phase = static_cast<float>(i) / (kNumPoints - 1);
+				PhaseDistortionOscillator::Evaluate(snapshot.patch, snapshot.voice, phase, &transfer[i], &wave[i]);
+			}
+			valid = true;
+		}
+		TransparentWidget::step();
+	}
+
+	void drawLayer(const DrawArgs& args, int layer) override {
+		if (layer == 1 && valid && (!enabled || *enabled)) {
+			const Vec center = box.size.div(2.0f);
+			const float radius = box.size.x / 2.0f;
+
+			nvgBeginPath(args.vg);
+			nvgCircle(args.vg, center.x, center.y, radius);
+			nvgFillColor(args.vg, nvgRGB(0x10, 0x10, 0x10));
+			nvgFill(args.vg);
+
+			// Plot area is the square inscribed in the circle, with a little margin
+			const float side = radius * 1.3f;
+			const Vec origin = center.minus(Vec(side / 2.0f, side / 2.0f));
+
+			nvgLineCap(args.vg, NVG_ROUND);
+			nvgLineJoin(args.vg, NVG_ROUND);
+
+			// Transfer curve, phase in (x) to phase out (y)
+			nvgBeginPath(args.vg);
+			for (int i = 0; i < kNumPoints; i++) {
+				float x = origin.x + side * i / (kNumPoints - 1);
+				float y = origin.y + side * (1.0f - transfer[i]);
+				if (i == 0) nvgMoveTo(args.vg, x, y);
+				else nvgLineTo(args.vg, x, y);
+			}
+			nvgStrokeColor(args.vg, nvgRGBA(0x52, 0x52, 0xf9, 0xa0));
+			nvgStrokeWidth(args.vg, 1.0f);
+			nvgStroke(args.vg);
+
+			// Waveform, one carrier cycle
+			nvgBeginPath(args.vg);
+			for (int i = 0; i < kNumPoints; i++) {
+				float x = origin.x + side * i / (kNumPoints - 1);
+				float y = origin.y + side * 0.5f * (1.0f - wave[i]);
+				if (i == 0) nvgMoveTo(args.vg, x, y);
+				else nvgLineTo(args.vg, x, y);
+			}
+			nvgStrokeColor(args.vg, nvgRGB(0xe6, 0xe6, 0xe6));
+			nvgStrokeWidth(args.vg, 1.25f);
+			nvgStroke(args.vg);
+		}
+		TransparentWidget::drawLayer(args, layer);
+	}
+
+private:
+	float transfer[kNumPoints] = {};
+	float wave[kNumPoints] = {};
+	bool valid = false;
+};
+
+}
@@ -1,7 +1,19 @@
+#include <math.h>
 #include "PDO.hpp"
+#include "simd/functions.hpp"
 
 using namespace infrasonic;
-using namespace rack::simd;
+using namespace infrasonic::simd;
+
+// Wavetable points rendered per block while building, about as much work as a direct block at 8x
+static const size_t kWavetableRenderChunk = 256;
+
+// How close amounts must be to count as settled, and to what the wavetable was rendered for
+static const float kWavetableAmtTolerance = 1e-4f;
+static const float kWavetablePmTolerance = 1e-5f;
+
+// Ext PM in cycles is clamped to this, far past any voltage but where fract() still keeps the phase
+static const float kMaxExtPM = 1000.0f;
 
 namespace infrasonic
 {
@@ -19,14 +31,18 @@ namespace infrasonic
         return expm1f(in * scale) / expm1f(scale);
     }
 
-    template<>
-    inline float_4 bend(float_4 in, const float_4 amt)
+    template<typename Kernels>
+    inline vfloat bend(vfloat in, const vfloat amt, Kernels)
     {
-        const float_4 scale = -10.0f * amt;
-        float_4 out = (exp(in * scale) - 1.0f) / (exp(scale) - 1.0f);
-        // The vectorized version is sensitive to near-zero denominators
-        float_4 tooSmall = (amt <= 1e-5f);
-        return (out & ~tooSmall) | (in & tooSmall);
+        const vfloat scale = -10.0f * amt;
+        const vfloat x = in * scale;
+        vfloat out = (Kernels::exp(x) - 1.0f) / (Kernels::exp(scale) - 1.0f);
+        // Both sides of the ratio cancel near zero amounts, where the error of exp() comes to
+        // dominate. Below 0.01 the series of expm1() to 4 terms is good to about 1e-6 instead,
+        // and is the identity at 0.
+        const vfloat series = in * (1.0f + x * (0.5f + x * (1.0f / 6.0f + x * (1.0f / 24.0f)))) /
+                              (1.0f + scale * (0.5f + scale * (1.0f / 6.0f + scale * (1.0f / 24.0f))));
+        return ifelse(amt < 0.01f, series, out);
     }
 
     template<typename T>
@@ -37,17 +53,17 @@ namespace infrasonic
     {
         float out;
         in = in + (in - 0.5f) * amt;
-        out = rack::math::clamp(in, 0.0f, 1.0f);
+        out = fminf(fmaxf(in, 0.0f), 1.0f);
         return out - floorf(out);
     }
 
     template<>
-    inline float_4 formant(float_4 in, const float_4 amt)
+    inline vfloat formant(vfloat in, const vfloat amt)
     {
-        float_4 out;
+        vfloat out;
         in = in + (in - 0.5f) * amt;
         out = clamp(in, 0.0f, 1.0f);
-        return out - floor(out);
+        return fract(out);
     }
 
     template<typename T>
@@ -61,10 +77,10 @@ namespace infrasonic
     }
 
     template<>
-    inline float_4 sync(float_4 in, const float_4 amt)
+    inline vfloat sync(vfloat in, const vfloat amt)
     {
         in *= 1.f + amt;
-        return in - floor(in);
+        return fract(in);
     }
 
     template<typename T>
@@ -76,32 +92,87 @@ namespace infrasonic
         float ft, sgn, out;
         in *= amt;
         ft  = floorf((in + 1.0f) * 0.5f);
-        sgn = static_cast<int>(ft) % 2 == 0 ? 1.0f : -1.0f;
+        // Parity in float like the vector version, the fold count can be past int range
+        sgn = ft - 2.0f * floorf(ft * 0.5f) == 0.0f ? 1.0f : -1.0f;
         out = sgn * (in - 2.0f * ft);
         return out - floorf(out);
     }
 
     template<>
-    inline float_4 fold(float_4 in, const float_4 amt)
+    inline vfloat fold(vfloat in, const vfloat amt)
     {
-        float_4 ft, sgn, out;
+        vfloat ft, odd, out;
         in *= amt;
         ft  = floor((in + 1.0f) * 0.5f);
-        // TODO: can this be vectorized?
-        for (int i=0; i<4; i++)
+        // Parity of the (integer valued) fold count, 0 or 1, without leaving float
+        odd = ft - 2.0f * floor(ft * 0.5f);
+        out = (1.0f - 2.0f * odd) * (in - 2.0f * ft);
+        return fract(out);
+    }
+}
+
+namespace infrasonic
+{
+    struct PreciseKernels
+    {
+        static inline vfloat sin2pi(const vfloat &x) { return simd::sin2pi(x); }
+        static inline vfloat cos2pi(const vfloat &x) { return simd::cos2pi(x); }
+        static inline vfloat exp2(const vfloat &x) { return simd::exp2(x); }
+        static inline vfloat exp(const vfloat &x) { return simd::exp(x); }
+    };
+
+    struct FastKernels
+    {
+        static inline vfloat sin2pi(const vfloat &x) { return simd::sin2pi_fast(x); }
+        static inline vfloat cos2pi(const vfloat &x) { return simd::cos2pi_fast(x); }
+        static inline vfloat exp2(const vfloat &x) { return simd::exp2_fast(x); }
+        static inline vfloat exp(const vfloat &x) { return simd::exp_fast(x); }
+    };
+
+    // Steps a smoother once per lane
+    inline vfloat processSmoothed(SmoothedValue &value)
+    {
+        float lanes[vfloat::size];
+        for (int i = 0; i < vfloat::size; i++)
         {
-            sgn[i] = static_cast<int>(ft[i]) % 2 == 0 ? 1.0f : -1.0f;
+            lanes[i] = value.Process();
         }
-        out = sgn * (in - 2.0f * ft);
-        return out - floor(out);
+        return vfloat::Load(lanes);
+    }
+
+    // Clamped like fclamp(), and flushed to 0 below kTinyParam
+    inline float sanitizeParam(const float x, const float hi)
+    {
+        static const float kTinyParam = 1e-9f;
+        const float clamped = fclamp(x, 0.0f, hi);
+        return clamped < kTinyParam ? 0.0f : clamped;
+    }
+
+    // Pitch to 0 - Nyquist and amounts to 0-1, NaN to 0, so no input can leave NaN or a
+    // denormal in the phasors or the smoothers that outlasts it. The phasors wrap whole
+    // cycles, so their phases stay in 0-1 up to Nyquist.
+    inline PhaseDistortionOscillator::VoiceParams sanitize(const PhaseDistortionOscillator::VoiceParams &voice, const float sample_rate)
+    {
+        PhaseDistortionOscillator::VoiceParams out;
+        out.carrier_freq = sanitizeParam(voice.carrier_freq, 0.5f * sample_rate);
+        out.pd_amt[0] = sanitizeParam(voice.pd_amt[0], 1.0f);
+        out.pd_amt[1] = sanitizeParam(voice.pd_amt[1], 1.0f);
+        out.pm_amt = sanitizeParam(voice.pm_amt, 1.0f);
+        return out;
     }
 }
 
-void PhaseDistortionOscillator::Init(const float sample_rate)
+void PhaseDistortionOscillator::Init(const float sample_rate, const float control_rate)
 {
+    sample_rate_ = sample_rate;
+    control_rate_ = control_rate;
+    output_rate_ = sample_rate;
     phasor_.Init(sample_rate);
     pm_phasor_.Init(sample_rate);
     sub_phasor_.Init(sample_rate);
+    ctl_phasor_.Init(control_rate);
+    ctl_pm_phasor_.Init(control_rate);
+    ctl_sub_phasor_.Init(control_rate);
     pd_1_amt_.Init(sample_rate, 0.02f);
     pd_2_amt_.Init(sample_rate, 0.02f);
     pm_amt_.Init(sample_rate, 0.02f);
@@ -110,6 +181,7 @@ void PhaseDistortionOscillator::Init(const float sample_rate)
 
 void PhaseDistortionOscillator::SetSampleRate(const float sample_rate)
 {
+    sample_rate_ = sample_rate;
     phasor_.SetSampleRate(sample_rate);
     pm_phasor_.SetSampleRate(sample_rate);
     sub_phasor_.SetSampleRate(sample_rate);
@@ -118,8 +190,47 @@ void PhaseDistortionOscillator::SetSampleRate(const float sample_rate)
     pm_amt_.SetSampleRate(sample_rate);
 }
 
+void PhaseDistortionOscillator::SetControlRate(const float control_rate)
+{
+    control_rate_ = control_rate;
+    ctl_phasor_.SetSampleRate(control_rate);
+    ctl_pm_phasor_.SetSampleRate(control_rate);
+    ctl_sub_phasor_.SetSampleRate(control_rate);
+}
+
+void PhaseDistortionOscillator::SetOutputRate(const float output_rate)
+{
+    output_rate_ = output_rate;
+}
+
+void PhaseDistortionOscillator::SetWavetable(MipmapWavetable *table)
+{
+    if (table == wavetable_)
+        return;
+    if (table && wavetable_ && wt_state_ != WT_EMPTY)
+    {
+        table->CopyFrom(*wavetable_);
+    }
+    else
+    {
+        wt_state_ = WT_EMPTY;
+        wt_level_ = -1;
+        if (table)
+            table->Reset();
+    }
+    wavetable_ = table;
+}
+
 void PhaseDistortionOscillator::Reset()
 {
+    wt_state_ = WT_EMPTY;
+    wt_level_ = -1;
+    if (wavetable_)
+        wavetable_->Reset();
+
+    sync_prev_ = 0.0f;
+    sync_pending_ = false;
+
     pd_1_amt_.Set(0.0f, true);
     pd_2_amt_ .Set(0.0f, true);
     pm_amt_.Set(0.0f, true);
@@ -129,118 +240,586 @@ void PhaseDistortionOscillator::Reset()
     sub_phasor_.SetFreq(110.0f);
 }
 
-void PhaseDistortionOscillator::ProcessBlock(const Patch &patch, const float *ext_pm_in, float *out, const size_t size)
+void PhaseDistortionOscillator::ProcessBlock(const Patch &patch, const VoiceParams &voice, const float *ext_pm_in, const float *sync_in, float *out, const size_t size)
+{
+    const VoiceParams safe_voice = sanitize(voice, sample_rate_);
+    if (patch.kernel_quality == KERNEL_QUALITY_FAST)
+        processBlock<FastKernels>(patch, safe_voice, ext_pm_in, sync_in, out, size);
+    else
+        processBlock<PreciseKernels>(patch, safe_voice, ext_pm_in, sync_in, out, size);
+}
+
+template <typename Kernels>
+void PhaseDistortionOscillator::processBlock(const Patch &patch, const VoiceParams &voice, const float *ext_pm_in, const float *sync_in, float *out, const size_t size)
 {
     size_t offset = 0;
-    float_4 pd1_amt4, pd2_amt4, ext_pm_in4;
-    float_4 pd4, pds4, win4;
-    float_4 out4, out_alt4;
+    vfloat pd1_amt, pd2_amt, ext_pm;
+    vfloat phase, cycles, pd, win;
+    vfloat pm = 0.0f, pds = 0.0f;
+    vfloat osc_out, alt_out = 0.0f;
+    float osc_lanes[vfloat::size], alt_lanes[vfloat::size];
+    float blep[2][vfloat::size];
+
+    phasor_.SetFreq(voice.carrier_freq);
+    if (!patch.phase_lock)
+    {
+        pm_phasor_.SetFreq(voice.carrier_freq * patch.pm_ratio);
+        sub_phasor_.SetFreq(voice.carrier_freq * 0.5f);
+    }
 
-    phasor_.SetFreq(patch.carrier_freq);
-    pm_phasor_.SetFreq(patch.carrier_freq * patch.pm_ratio);
-    sub_phasor_.SetFreq(patch.carrier_freq * 0.5f);
+    pd_1_amt_.Set(voice.pd_amt[0]);
+    pd_2_amt_.Set(voice.pd_amt[1]);
+    pm_amt_.Set(voice.pm_amt);
 
-    pd_1_amt_.Set(patch.pd_amt[0]);
-    pd_2_amt_.Set(patch.pd_amt[1]);
-    pm_amt_.Set(patch.pm_amt);
+    // Wavetable levels for this block and the last, -1 for direct synthesis.
+    // The block where either changes crossfades from one to the other.
+    const int prev_level = wt_level_;
+    const int level = updateWavetable(patch, voice, ext_pm_in, sync_in, size);
+    const bool direct = level < 0 || prev_level < 0;
+    const vfloat fade_step = 1.0f / size;
+    wt_level_ = level;
 
     while (offset < size)
     {
-        ext_pm_in4 = float_4::load(ext_pm_in + offset);
-        pd4 = phasor_.Process();
-        pds4 = sub_phasor_.Process();
-        win4 = processWindow(patch.win_type, pd4);
-
-        if (patch.alt_out_type == OUT_TYPE_SIN) {
-            out_alt4 = sin(pd4 * M_PI * 2.0f);
+        phase = phasor_.Process();
+        cycles = phasor_.GetCycles();
+        if (!patch.phase_lock)
+        {
+            pm = pm_phasor_.Process();
+            pds = sub_phasor_.Process();
         }
 
-        pd1_amt4 = {pd_1_amt_.Process(), pd_1_amt_.Process(), pd_1_amt_.Process(), pd_1_amt_.Process()};
-        pd2_amt4 = {pd_2_amt_.Process(), pd_2_amt_.Process(), pd_2_amt_.Process(), pd_2_amt_.Process()};
-        if (patch.routing == Routing::ROUTING_PM_PRE)
+        // Rising zero crossings of sync, each lane against the one before. Nearly every step
+        // has none, and only pays for the compare.
+        int edges = 0;
+        float sync_before = 0.0f;
+        if (sync_in)
         {
-            pd4 = processPhaseMod(pd4, ext_pm_in4, patch.pm_ratio);
+            const vfloat sync = vfloat::Load(sync_in + offset);
+            vfloat sync_prev;
+            if (offset > 0)
+            {
+                sync_before = sync_in[offset - 1];
+                sync_prev = vfloat::Load(sync_in + offset - 1);
+            }
+            else
+            {
+                float lanes[vfloat::size];
+                lanes[0] = sync_before = sync_prev_;
+                for (int i = 1; i < vfloat::size; i++)
+                    lanes[i] = sync_in[i - 1];
+                sync_prev = vfloat::Load(lanes);
+            }
+            edges = movemask((sync > 0.0f) & (sync_prev <= 0.0f));
         }
+        const bool synced = (edges != 0 || sync_pending_) &&
+                            processSync(patch, edges, sync_in ? sync_in + offset : nullptr, sync_before, ext_pm_in + offset,
+                                        phase, cycles, pm, pds, blep);
 
-        pd4 = processPhaseDist(patch.pd_type[0], pd4, pd1_amt4);
-        pd4 = processPhaseDist(patch.pd_type[1], pd4, pd2_amt4);
+        if (patch.phase_lock)
+        {
+            // Exact up to float rounding, and continuous where the cycle count wraps around
+            pm = fract((cycles + phase) * patch.pm_ratio);
+            pds = (cycles - 2.0f * floor(cycles * 0.5f) + phase) * 0.5f;
+        }
 
-        if (patch.routing == Routing::ROUTING_PM_POST)
+        if (direct)
         {
-            pd4 = processPhaseMod(pd4, ext_pm_in4, patch.pm_ratio);
+            ext_pm = clamp(vfloat::Load(ext_pm_in + offset), -kMaxExtPM, kMaxExtPM);
+            pd = phase;
+            win = processWindow(patch.win_type, pd);
+
+            if (patch.alt_out_enabled && patch.alt_out_type == OUT_TYPE_SIN) {
+                alt_out = Kernels::sin2pi(pd);
+            }
+
+            pd1_amt = processSmoothed(pd_1_amt_);
+            pd2_amt = processSmoothed(pd_2_amt_);
+            if (patch.routing == Routing::ROUTING_PM_PRE)
+            {
+                pd = processPhaseMod<Kernels>(pd, pm, ext_pm, patch.pm_ratio);
+            }
+
+            pd = processPhaseDist<Kernels>(patch.pd_type[0], pd, pd1_amt, patch.warp_table);
+            pd = processPhaseDist<Kernels>(patch.pd_type[1], pd, pd2_amt, patch.warp_table);
+
+            if (patch.routing == Routing::ROUTING_PM_POST)
+            {
+                pd = processPhaseMod<Kernels>(pd, pm, ext_pm, patch.pm_ratio);
+            }
+
+            osc_out = Kernels::sin2pi(pd) * win;
+
+            switch (patch.alt_out_enabled ? patch.alt_out_type : OUT_TYPE_LAST)
+            {
+                case OUT_TYPE_90:
+                    alt_out = Kernels::cos2pi(pd) * win;
+                    break;
+                case OUT_TYPE_SIN:
+                    // Already processed above before PD/PM
+                    break;
+                case OUT_TYPE_SUB:
+                    alt_out = Kernels::sin2pi(pds);
+                    break;
+                case OUT_TYPE_PHASOR:
+                    alt_out = pd;
+                    break;
+                default:
+                    break;
+            }
         }
 
-        out4 = sin(pd4 * M_PI * 2.0f) * win4;
+        if (level >= 0 || prev_level >= 0)
+        {
+            // Rises from 0 at the start of the block to 1 at its end
+            const vfloat fade = (static_cast<float>(offset + 1) + vfloat::Ramp()) * fade_step;
+            vfloat wt_osc, wt_alt, from_osc, from_alt;
+
+            if (level >= 0 && prev_level >= 0)
+            {
+                playWavetable<Kernels>(patch, level, phase, pds, wt_osc, wt_alt);
+                if (level != prev_level)
+                {
+                    playWavetable<Kernels>(patch, prev_level, phase, pds, from_osc, from_alt);
+                    wt_osc = from_osc + (wt_osc - from_osc) * fade;
+                    wt_alt = from_alt + (wt_alt - from_alt) * fade;
+                }
+                osc_out = wt_osc;
+                alt_out = wt_alt;
+            }
+            else if (level >= 0)
+            {
+                playWavetable<Kernels>(patch, level, phase, pds, wt_osc, wt_alt);
+                osc_out += (wt_osc - osc_out) * fade;
+                alt_out += (wt_alt - alt_out) * fade;
+            }
+            else
+            {
+                playWavetable<Kernels>(patch, prev_level, phase, pds, wt_osc, wt_alt);
+                osc_out = wt_osc + (osc_out - wt_osc) * fade;
+                alt_out = wt_alt + (alt_out - wt_alt) * fade;
+            }
+        }
 
-        switch (patch.alt_out_type)
+        if (synced)
         {
-            case OUT_TYPE_90:
-                out_alt4 = cos(pd4 * M_PI * 2.0f) * win4;
-                break;
-            case OUT_TYPE_SIN:
-                // Already processed above before PD/PM
-                break;
-            case OUT_TYPE_SUB:
-                out_alt4 = sin(pds4 * M_PI * 2.0f); 
-                break;
-            case OUT_TYPE_PHASOR:
-                out_alt4 = pd4;
-                break;
-            default:
-                break;
+            osc_out += vfloat::Load(blep[0]);
+            alt_out += vfloat::Load(blep[1]);
         }
 
-        // TODO: faster way to do this?
-        for (int i = 0; i < 4; i++)
+        osc_out.Store(osc_lanes);
+        alt_out.Store(alt_lanes);
+        for (int i = 0; i < vfloat::size; i++)
         {
-            out[offset * 2]      = out4[i];
-            out[offset * 2 + 1]  = out_alt4[i];
+            out[offset * 2]      = osc_lanes[i];
+            out[offset * 2 + 1]  = alt_lanes[i];
             offset++;
         }
     }
+
+    sync_prev_ = sync_in ? sync_in[size - 1] : 0.0f;
+}
+
+bool PhaseDistortionOscillator::processSync(const Patch &patch, const int edges, const float *sync, const float sync_before, const float *ext_pm,
+                                            vfloat &phase, vfloat &cycles, const vfloat pm, const vfloat pds,
+                                            float (&blep)[2][vfloat::size])
+{
+    for (int c = 0; c < 2; c++)
+        for (int i = 0; i < vfloat::size; i++)
+            blep[c][i] = 0.0f;
+
+    // Left over from the last lane of the previous step
+    if (sync_pending_)
+    {
+        phasor_.Sync(phase, cycles, 0, sync_pending_frac_);
+        blep[0][0] = sync_pending_blep_[0];
+        blep[1][0] = sync_pending_blep_[1];
+        sync_pending_ = false;
+    }
+
+    const float inc = phasor_.GetIncrement();
+    for (int j = 0; j < vfloat::size; j++)
+    {
+        if (!(edges & (1 << j)))
+            continue;
+
+        // The crossing is d of a sample after sync[j - 1], so the restart falls d after lane j
+        const float prev = j > 0 ? sync[j - 1] : sync_before;
+        // Clamped for crossings from or to infinity, which give NaN
+        const float d = fclamp(prev / (prev - sync[j]), 0.0f, 1.0f);
+
+        // Step from where the carrier would have been to where it starts over
+        float ph = phase[j] + d * inc;
+        float cy = cycles[j];
+        if (ph >= 1.0f)
+        {
+            ph -= 1.0f;
+            cy = cy + 1.0f < Phasor::kCycleModulus ? cy + 1.0f : 0.0f;
+        }
+        float before[2], after[2];
+        evaluateSync(patch, ph, cy, pm[j], pds[j], ext_pm[j], before);
+        evaluateSync(patch, 0.0f, 0.0f, pm[j], pds[j], ext_pm[j], after);
+
+        // 2-point polyBLEP, half the residual before the step and half after
+        float blep_after[2];
+        for (int c = 0; c < 2; c++)
+        {
+            const float half_step = 0.5f * (after[c] - before[c]);
+            blep[c][j] += half_step * (1.0f - d) * (1.0f - d);
+            blep_after[c] = -half_step * d * d;
+        }
+
+        if (j + 1 < vfloat::size)
+        {
+            phasor_.Sync(phase, cycles, j + 1, 1.0f - d);
+            blep[0][j + 1] += blep_after[0];
+            blep[1][j + 1] += blep_after[1];
+        }
+        else
+        {
+            sync_pending_ = true;
+            sync_pending_frac_ = 1.0f - d;
+            sync_pending_blep_[0] = blep_after[0];
+            sync_pending_blep_[1] = blep_after[1];
+        }
+    }
+
+    return true;
+}
+
+void PhaseDistortionOscillator::evaluateSync(const Patch &patch, const float phase, const float cycles, float pm, float pds, const float ext_pm, float *out) const
+{
+    if (patch.phase_lock)
+    {
+        pm = (cycles + phase) * patch.pm_ratio;
+        pm -= floorf(pm);
+        pds = (fmodf(cycles, 2.0f) + phase) * 0.5f;
+    }
+
+    const float mod = sinf(pm * kTwoPi) * (pm_amt_.Get() * 10.0f / patch.pm_ratio) + fclamp(ext_pm, -kMaxExtPM, kMaxExtPM);
+    float pd = phase;
+
+    if (patch.routing == Routing::ROUTING_PM_PRE)
+    {
+        pd += mod;
+        pd -= floorf(pd);
+    }
+
+    pd = processPhaseDist(patch.pd_type[0], pd, pd_1_amt_.Get(), patch.warp_table);
+    pd = processPhaseDist(patch.pd_type[1], pd, pd_2_amt_.Get(), patch.warp_table);
+
+    if (patch.routing == Routing::ROUTING_PM_POST)
+    {
+        pd += mod;
+        pd -= floorf(pd);
+    }
+
+    const float win = processWindow(patch.win_type, phase);
+    out[0] = sinf(pd * kTwoPi) * win;
+
+    switch (patch.alt_out_enabled ? patch.alt_out_type : OUT_TYPE_LAST)
+    {
+        case OUT_TYPE_90:
+            out[1] = cosf(pd * kTwoPi) * win;
+            break;
+        case OUT_TYPE_SIN:
+            out[1] = sinf(phase * kTwoPi);
+            break;
+        case OUT_TYPE_SUB:
+            out[1] = sinf(pds * kTwoPi);
+            break;
+        case OUT_TYPE_PHASOR:
+            out[1] = pd;
+            break;
+        default:
+            out[1] = 0.0f;
+            break;
+    }
+}
+
+void PhaseDistortionOscillator::ProcessControl(const Patch &patch, const VoiceParams &unsafe_voice, const float ext_pm_in, const bool sync, float *out)
+{
+    const VoiceParams voice = sanitize(unsafe_voice, control_rate_);
+    float pd, pds, pm, win, out_alt = 0.0f;
+
+    ctl_phasor_.SetFreq(voice.carrier_freq);
+    if (sync)
+        ctl_phasor_.Reset();
+    pd = ctl_phasor_.Process();
+
+    if (patch.phase_lock)
+    {
+        const int cycles = ctl_phasor_.GetCycles();
+        pm = (cycles + pd) * patch.pm_ratio;
+        pm -= floorf(pm);
+        pds = (cycles % 2 + pd) * 0.5f;
+    }
+    else
+    {
+        ctl_pm_phasor_.SetFreq(voice.carrier_freq * patch.pm_ratio);
+        ctl_sub_phasor_.SetFreq(voice.carrier_freq * 0.5f);
+        pm = ctl_pm_phasor_.Process();
+        pds = ctl_sub_phasor_.Process();
+    }
+
+    pm = sinf(pm * kTwoPi) * (voice.pm_amt * 10.0f / patch.pm_ratio) + fclamp(ext_pm_in, -kMaxExtPM, kMaxExtPM);
+    win = processWindow(patch.win_type, pd);
+
+    if (patch.alt_out_type == OUT_TYPE_SIN) {
+        out_alt = sinf(pd * kTwoPi);
+    }
+
+    if (patch.routing == Routing::ROUTING_PM_PRE)
+    {
+        pd += pm;
+        pd -= floorf(pd);
+    }
+
+    pd = processPhaseDist(patch.pd_type[0], pd, voice.pd_amt[0], patch.warp_table);
+    pd = processPhaseDist(patch.pd_type[1], pd, voice.pd_amt[1], patch.warp_table);
+
+    if (patch.routing == Routing::ROUTING_PM_POST)
+    {
+        pd += pm;
+        pd -= floorf(pd);
+    }
+
+    switch (patch.alt_out_type)
+    {
+        case OUT_TYPE_90:
+            out_alt = cosf(pd * kTwoPi) * win;
+            break;
+        case OUT_TYPE_SUB:
+            out_alt = sinf(pds * kTwoPi);
+            break;
+        case OUT_TYPE_PHASOR:
+            out_alt = pd;
+            break;
+        default:
+            break;
+    }
+
+    out[0] = sinf(pd * kTwoPi) * win;
+    out[1] = out_alt;
+}
+
+void PhaseDistortionOscillator::Evaluate(const Patch &patch, const VoiceParams &voice, const float phase, float *warped, float *out)
+{
+    float pd = phase;
+    float pm_phase = phase * patch.pm_ratio;
+    float pm = sinf((pm_phase - floorf(pm_phase)) * kTwoPi) * (voice.pm_amt * 10.0f / patch.pm_ratio);
+
+    if (patch.routing == Routing::ROUTING_PM_PRE)
+    {
+        pd += pm;
+        pd -= floorf(pd);
+    }
+
+    pd = processPhaseDist(patch.pd_type[0], pd, voice.pd_amt[0], patch.warp_table);
+    pd = processPhaseDist(patch.pd_type[1], pd, voice.pd_amt[1], patch.warp_table);
+
+    if (patch.routing == Routing::ROUTING_PM_POST)
+    {
+        pd += pm;
+        pd -= floorf(pd);
+    }
+
+    *warped = pd;
+    *out = sinf(pd * kTwoPi) * processWindow(patch.win_type, phase);
 }
 
 // returns phase
-float_4 PhaseDistortionOscillator::processPhaseMod(float_4 phase, const float_4 ext_pm_in, const float ratio)
+template <typename Kernels>
+vfloat PhaseDistortionOscillator::processPhaseMod(vfloat phase, const vfloat pm_phase, const vfloat ext_pm_in, const float ratio)
 {
-        float_4 amt(pm_amt_.Process(), pm_amt_.Process(), pm_amt_.Process(), pm_amt_.Process());
-        float_4 mod = sin(pm_phasor_.Process() * M_PI * 2.0f);
-        phase += mod * (amt * 10.0f / ratio) + ext_pm_in;
-        return phase - floor(phase);
+        vfloat amt = processSmoothed(pm_amt_);
+        vfloat mod = Kernels::sin2pi(pm_phase);
+        phase += mod * (amt * (10.0f / ratio)) + ext_pm_in;
+        return fract(phase);
 }
 
-float_4 PhaseDistortionOscillator::processPhaseDist(const PhaseDistType type, const float_4 phase, const float_4 amt) const
+template <typename Kernels>
+vfloat PhaseDistortionOscillator::processPhaseDist(const PhaseDistType type, const vfloat phase, const vfloat amt, const WarpTable *table) const
 {   
     switch(type)
     {
         case PD_TYPE_BEND:
-            return bend(phase, amt);
+            return bend(phase, amt, Kernels());
 
         case PD_TYPE_SYNC:
-            return sync(phase, pow(2.0f, amt * 5.0f) - 1.0f);
+            return sync(phase, Kernels::exp2(amt * 5.0f) - 1.0f);
 
         case PD_TYPE_FORMANT:
-            return formant(phase, pow(2.0f, amt * 5.0f) - 1.0f);
+            return formant(phase, Kernels::exp2(amt * 5.0f) - 1.0f);
 
         case PD_TYPE_FOLD:
-            return fold(phase, pow(2.0f, amt * 5.0f));
+            return fold(phase, Kernels::exp2(amt * 5.0f));
+
+        case PD_TYPE_CUSTOM:
+            return table ? table->Process(phase, amt) : phase;
 
         default:
             return phase;
     }
 }
 
-float_4 PhaseDistortionOscillator::processWindow(const WindowType type, const float_4 phase) const
+vfloat PhaseDistortionOscillator::processWindow(const WindowType type, const vfloat phase) const
 {   
     switch (type)
     {
         case WIN_TYPE_SAW:
             return 1.0f - phase;
-        case WIN_TYPE_TRI: {
-            float_4 cmp = phase < 0.5f;
-            return (cmp & (phase * 2.0f)) | (~cmp & (1.0f - (phase - 0.5f) * 2.0f));
-        }
+        case WIN_TYPE_TRI:
+            return ifelse(phase < 0.5f, phase * 2.0f, 1.0f - (phase - 0.5f) * 2.0f);
+        default:
+            return 1.0f;
+    }
+}
+
+float PhaseDistortionOscillator::processPhaseDist(const PhaseDistType type, const float phase, const float amt, const WarpTable *table)
+{
+    switch(type)
+    {
+        case PD_TYPE_BEND:
+            return bend(phase, amt);
+
+        case PD_TYPE_SYNC:
+            return sync(phase, exp2f(amt * 5.0f) - 1.0f);
+
+        case PD_TYPE_FORMANT:
+            return formant(phase, exp2f(amt * 5.0f) - 1.0f);
+
+        case PD_TYPE_FOLD:
+            return fold(phase, exp2f(amt * 5.0f));
+
+        case PD_TYPE_CUSTOM:
+            return table ? table->Process(phase, amt) : phase;
+
+        default:
+            return phase;
+    }
+}
+
+float PhaseDistortionOscillator::processWindow(const WindowType type, const float phase)
+{
+    switch (type)
+    {
+        case WIN_TYPE_SAW:
+            return 1.0f - phase;
+        case WIN_TYPE_TRI:
+            return phase < 0.5f ? phase * 2.0f : 1.0f - (phase - 0.5f) * 2.0f;
         default:
             return 1.0f;
     }
-}
\ No newline at end of file
+}
+
+int PhaseDistortionOscillator::updateWavetable(const Patch &patch, const VoiceParams &voice, const float *ext_pm_in, const float *sync_in, const size_t size)
+{
+    if (!patch.wavetable_enabled || !wavetable_ || sync_in)
+        return -1;
+
+    // The carrier only wraps once per step, so beyond that its phases leave 0-1
+    if (voice.carrier_freq * vfloat::size >= sample_rate_)
+        return -1;
+
+    // Enough harmonics to fill the output band, but none at or above this rate's Nyquist frequency
+    int level = MipmapWavetable::GetLevel(0.5f * output_rate_ / voice.carrier_freq);
+    if (level < 0)
+        return -1;
+    while (level < static_cast<int>(MipmapWavetable::kNumLevels) - 1 &&
+           MipmapWavetable::GetHarmonics(level) * voice.carrier_freq >= 0.5f * sample_rate_)
+        level++;
+
+    // Settled: amounts at their targets, no PM of either kind, and no output the table can't hold
+    bool settled = voice.pm_amt == 0.0f && pm_amt_.Get() < kWavetablePmTolerance &&
+                   fabsf(pd_1_amt_.Get() - voice.pd_amt[0]) < kWavetableAmtTolerance &&
+                   fabsf(pd_2_amt_.Get() - voice.pd_amt[1]) < kWavetableAmtTolerance &&
+                   !(patch.alt_out_enabled && patch.alt_out_type == OUT_TYPE_PHASOR);
+    for (size_t i = 0; settled && i < size; i += vfloat::size)
+        settled = movemask(vfloat::Load(ext_pm_in + i) != 0.0f) == 0;
+    if (!settled)
+        return -1;
+
+    const bool custom = patch.pd_type[0] == PD_TYPE_CUSTOM || patch.pd_type[1] == PD_TYPE_CUSTOM;
+    const uint32_t warp_id = patch.warp_table ? patch.warp_table->GetId() : 0;
+    const bool same_key = wt_state_ != WT_EMPTY &&
+                          wt_key_.pd_type[0] == patch.pd_type[0] && wt_key_.pd_type[1] == patch.pd_type[1] &&
+                          fabsf(wt_key_.pd_amt[0] - voice.pd_amt[0]) < kWavetableAmtTolerance &&
+                          fabsf(wt_key_.pd_amt[1] - voice.pd_amt[1]) < kWavetableAmtTolerance &&
+                          wt_key_.win_type == patch.win_type && (!custom || wt_key_.warp_id == warp_id);
+    if (!same_key)
+    {
+        // A table still fading out can't be overwritten yet
+        if (wt_level_ >= 0)
+            return -1;
+        wt_key_.pd_type[0] = patch.pd_type[0];
+        wt_key_.pd_type[1] = patch.pd_type[1];
+        wt_key_.pd_amt[0] = voice.pd_amt[0];
+        wt_key_.pd_amt[1] = voice.pd_amt[1];
+        wt_key_.win_type = patch.win_type;
+        wt_key_.warp_table = patch.warp_table;
+        wt_key_.warp_id = warp_id;
+        wt_state_ = WT_RENDER;
+        wt_render_pos_ = 0;
+        wavetable_->Reset();
+    }
+
+    switch (wt_state_)
+    {
+        case WT_RENDER:
+            renderWavetable(kWavetableRenderChunk);
+            if (wt_render_pos_ == MipmapWavetable::kSize)
+                wt_state_ = WT_BUILD;
+            return -1;
+        case WT_BUILD:
+            if (wavetable_->Build())
+                wt_state_ = WT_READY;
+            return -1;
+        case WT_READY:
+            return level;
+        default:
+            return -1;
+    }
+}
+
+// One cycle without PM, always with the precise kernels since it is played back many times
+void PhaseDistortionOscillator::renderWavetable(const size_t count)
+{
+    float *main = wavetable_->GetCycle(0);
+    float *alt = wavetable_->GetCycle(1);
+    const vfloat amt_1 = wt_key_.pd_amt[0];
+    const vfloat amt_2 = wt_key_.pd_amt[1];
+    const size_t end = wt_render_pos_ + count < MipmapWavetable::kSize ? wt_render_pos_ + count : MipmapWavetable::kSize;
+
+    for (size_t i = wt_render_pos_; i < end; i += vfloat::size)
+    {
+        const vfloat phase = (static_cast<float>(i) + vfloat::Ramp()) * (1.0f / MipmapWavetable::kSize);
+        vfloat pd = processPhaseDist<PreciseKernels>(wt_key_.pd_type[0], phase, amt_1, wt_key_.warp_table);
+        pd = processPhaseDist<PreciseKernels>(wt_key_.pd_type[1], pd, amt_2, wt_key_.warp_table);
+        const vfloat win = processWindow(wt_key_.win_type, phase);
+        (PreciseKernels::sin2pi(pd) * win).Store(main + i);
+        (PreciseKernels::cos2pi(pd) * win).Store(alt + i);
+    }
+    wt_render_pos_ = end;
+}
+
+template <typename Kernels>
+void PhaseDistortionOscillator::playWavetable(const Patch &patch, const int level, const vfloat phase, const vfloat sub_phase, vfloat &osc_out, vfloat &alt_out) const
+{
+    osc_out = wavetable_->Process(0, level, phase);
+    switch (patch.alt_out_enabled ? patch.alt_out_type : OUT_TYPE_LAST)
+    {
+        case OUT_TYPE_90:
+            alt_out = wavetable_->Process(1, level, phase);
+            break;
+        case OUT_TYPE_SIN:
+            alt_out = Kernels::sin2pi(phase);
+            break;
+        case OUT_TYPE_SUB:
+            alt_out = Kernels::sin2pi(sub_phase);
+            break;
+        default:
+            alt_out = 0.0f;
+            break;
+    }
+}
@@ -1,9 +1,13 @@
 #pragma once
 
+#include <cstddef>
 #include <cstdint>
-#include <simd/functions.hpp>
-#include "phasor4.hpp"
+#include "simd/vfloat.hpp"
+#include "phasor.hpp"
+#include "vphasor.hpp"
 #include "smooth.hpp"
+#include "warp_table.hpp"
+#include "wavetable.hpp"
 
 namespace infrasonic
 {
@@ -24,6 +28,7 @@ namespace infrasonic
                 PD_TYPE_SYNC,
                 PD_TYPE_FORMANT,
                 PD_TYPE_FOLD,
+                PD_TYPE_CUSTOM,
                 PD_TYPE_LAST
             };
 
@@ -44,49 +49,187 @@ namespace infrasonic
                 OUT_TYPE_LAST
             };
 
+            // Accuracy of the vector sine and exp approximations
+            enum KernelQuality
+            {
+                KERNEL_QUALITY_HIGH,
+                KERNEL_QUALITY_FAST,
+                KERNEL_QUALITY_LAST
+            };
+
+            // Settings shared by all voices
             struct Patch
             {
-                float           carrier_freq;
-                float           pd_amt[2];
-                float           pm_amt;
                 float           pm_ratio;
                 Routing         routing;
                 PhaseDistType   pd_type[2];
                 WindowType      win_type;
                 AltOutputType   alt_out_type;
+                KernelQuality   kernel_quality;
+                bool            alt_out_enabled; // alt_out is 0 and not computed when false
+
+                // Derive the PM modulator and sub phases from the carrier's phase and cycle count
+                // instead of running them freely, so they can never drift from the carrier.
+                // pm_ratio times Phasor::kCycleModulus must be a whole number.
+                bool            phase_lock;
+
+                // Play settled voices without PM from a band-limited wavetable when their pitch
+                // is high enough, see ProcessBlock()
+                bool            wavetable_enabled;
+
+                // Curve for PD_TYPE_CUSTOM, which passes the phase through unchanged when null.
+                // Owned by the caller and must outlive any block processed with it.
+                const WarpTable *warp_table;
 
                 Patch()
-                    : carrier_freq(220.0f)
-                    , pm_amt(0.0f)
-                    , pm_ratio(1.0f)
+                    : pm_ratio(1.0f)
                     , routing(ROUTING_PM_PRE)
                     , win_type(WIN_TYPE_NONE)
                     , alt_out_type(OUT_TYPE_90)
+                    , kernel_quality(KERNEL_QUALITY_HIGH)
+                    , alt_out_enabled(true)
+                    , phase_lock(false)
+                    , wavetable_enabled(false)
+                    , warp_table(nullptr)
                 {
-                    pd_amt[0] = 0.0f;
-                    pd_amt[1] = 0.0f;
                     pd_type[0] = PD_TYPE_BEND;
                     pd_type[1] = PD_TYPE_SYNC;
                 }
             };
 
+            // Per-voice parameters, packed as 4 floats so a SIMD group of
+            // voices can be written with one 4x4 transpose. Anything out of range,
+            // NaN included, is clamped: pitch to 0 - Nyquist, amounts to 0-1.
+            struct VoiceParams
+            {
+                float carrier_freq;
+                float pd_amt[2];
+                float pm_amt;
+
+                VoiceParams()
+                    : carrier_freq(220.0f)
+                    , pm_amt(0.0f)
+                {
+                    pd_amt[0] = 0.0f;
+                    pd_amt[1] = 0.0f;
+                }
+            };
+
             PhaseDistortionOscillator() = default;
             ~PhaseDistortionOscillator() = default;
 
-            void Init(const float sample_rate);
+            void Init(const float sample_rate, const float control_rate);
             void SetSampleRate(const float sample_rate);
+            void SetControlRate(const float control_rate);
             void Reset();
 
-            // Interleaved 2-channel block {osc_out, alt_out} of size
-            void ProcessBlock(const Patch &patch, const float *ext_pm_in, float *out, const size_t size);
+            // Rate the output is eventually resampled to, which bounds the harmonics the
+            // wavetable engine has to keep. Defaults to the sample rate.
+            void SetOutputRate(const float output_rate);
+
+            // Table for the wavetable engine, owned by the caller and only used until the next
+            // call. Without one (the default) the voice always synthesizes directly. A table that
+            // replaces another takes over what the old one held, so playback carries on.
+            // Realtime safe, the table must already be initialized.
+            void SetWavetable(MipmapWavetable *table);
+
+            // Interleaved 2-channel block {osc_out, alt_out} of size,
+            // which must be a multiple of simd::vfloat::size.
+            //
+            // With wavetable_enabled, a voice whose warp amounts have settled and that has no
+            // internal or external PM is rendered once into a mipmapped wavetable, a part per
+            // block, and then played back from it while it stays that way, as long as its pitch
+            // needs no more than MipmapWavetable::kMaxHarmonics below the output Nyquist frequency.
+            // Switching between the two crossfades over one block.
+            //
+            // sync_in is null or size samples of a hard sync signal. Each rising zero crossing
+            // restarts the carrier at its sub-sample position, interpolated between the samples
+            // on either side, one sample later than the crossing. With phase_lock the PM
+            // modulator and sub restart with it. The step in the outputs is band-limited with
+            // a polyBLEP. Voices with sync are never played from the wavetable.
+            //
+            // Neither input needs to be finite. Ext PM is clamped to +-1000 cycles, NaN to the
+            // lower end, and sync crossings from or to infinity restart at the sample.
+            void ProcessBlock(const Patch &patch, const VoiceParams &voice, const float *ext_pm_in, const float *sync_in, float *out, const size_t size);
+
+            // Single 2-channel frame {osc_out, alt_out} at control rate.
+            // Amounts are applied unsmoothed, the caller is expected to
+            // interpolate between successive frames. sync restarts the carrier
+            // (and with phase_lock the PM modulator and sub) before this frame.
+            void ProcessControl(const Patch &patch, const VoiceParams &voice, const float ext_pm_in, const bool sync, float *out);
+
+            // Stateless evaluation at carrier phase 0-1 for visualization, without
+            // smoothing or ext PM. Outputs the warped phase and main oscillator output.
+            static void Evaluate(const Patch &patch, const VoiceParams &voice, const float phase, float *warped, float *out);
 
         private:
-            simd::Phasor4 phasor_, sub_phasor_, pm_phasor_;
+            simd::VPhasor phasor_, sub_phasor_, pm_phasor_;
+            Phasor ctl_phasor_, ctl_sub_phasor_, ctl_pm_phasor_;
 
             SmoothedValue pd_1_amt_, pd_2_amt_, pm_amt_;
 
-            rack::simd::float_4 processPhaseMod(rack::simd::float_4 phase, const rack::simd::float_4 ext_pm_in, const float ratio);
-            rack::simd::float_4 processPhaseDist(const PhaseDistType type, const rack::simd::float_4 phase, const rack::simd::float_4 amt) const;
-            rack::simd::float_4 processWindow(const WindowType type, const rack::simd::float_4 phase) const;
+            // Hard sync. A restart found in the last lane of a step lands in the first lane of
+            // the next, possibly in the next block, together with its share of the polyBLEP.
+            float sync_prev_ = 0.0f;
+            bool sync_pending_ = false;
+            float sync_pending_frac_ = 0.0f;
+            float sync_pending_blep_[2] = {};
+
+            // Wavetable engine. The key is what the table was (or is being) rendered for. The
+            // custom curve is part of it only while a side uses it, and is matched by id.
+            enum WavetableState
+            {
+                WT_EMPTY,
+                WT_RENDER,
+                WT_BUILD,
+                WT_READY
+            };
+            struct WavetableKey
+            {
+                PhaseDistType   pd_type[2];
+                float           pd_amt[2];
+                WindowType      win_type;
+                const WarpTable *warp_table;
+                uint32_t        warp_id;
+            };
+            MipmapWavetable *wavetable_ = nullptr;
+            WavetableState wt_state_ = WT_EMPTY;
+            WavetableKey wt_key_;
+            size_t wt_render_pos_ = 0;
+            int wt_level_ = -1; // level played in the last block, -1 when synthesizing directly
+            float sample_rate_ = 48000.0f, control_rate_ = 6000.0f, output_rate_ = 48000.0f;
+
+            // Returns the level to play this block from, or -1 to synthesize directly,
+            // and advances the table build by one step
+            int updateWavetable(const Patch &patch, const VoiceParams &voice, const float *ext_pm_in, const float *sync_in, const size_t size);
+            void renderWavetable(const size_t count);
+
+            template <typename Kernels>
+            void playWavetable(const Patch &patch, const int level, const simd::vfloat phase, const simd::vfloat sub_phase, simd::vfloat &osc_out, simd::vfloat &alt_out) const;
+
+            // Applies the restarts in one step of the carrier. edges has a bit per lane whose sync
+            // sample rose through zero from the one before it, sync_before being the one before
+            // sync[0]. Adds the polyBLEP corrections for the step to blep, returns true if any.
+            bool processSync(const Patch &patch, const int edges, const float *sync, const float sync_before, const float *ext_pm,
+                             simd::vfloat &phase, simd::vfloat &cycles, const simd::vfloat pm, const simd::vfloat pds,
+                             float (&blep)[2][simd::vfloat::size]);
+
+            // Outputs just before and after a restart, for the size of its step
+            void evaluateSync(const Patch &patch, const float phase, const float cycles, float pm, float pds, const float ext_pm, float *out) const;
+
+            // Kernels supplies the sine and exp approximations for a KernelQuality
+            template <typename Kernels>
+            void processBlock(const Patch &patch, const VoiceParams &voice, const float *ext_pm_in, const float *sync_in, float *out, const size_t size);
+
+            template <typename Kernels>
+            simd::vfloat processPhaseMod(simd::vfloat phase, const simd::vfloat pm_phase, const simd::vfloat ext_pm_in, const float ratio);
+
+            template <typename Kernels>
+            simd::vfloat processPhaseDist(const PhaseDistType type, const simd::vfloat phase, const simd::vfloat amt, const WarpTable *table) const;
+
+            simd::vfloat processWindow(const WindowType type, const simd::vfloat phase) const;
+
+            static float processPhaseDist(const PhaseDistType type, const float phase, const float amt, const WarpTable *table);
+            static float processWindow(const WindowType type, const float phase);
     };
 }
\ No newline at end of file
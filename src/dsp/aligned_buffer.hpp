@@ -0,0 +1,63 @@
+#pragma once
+#ifndef INFS_ALIGNED_BUFFER_H
+#define INFS_ALIGNED_BUFFER_H
+
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <memory>
+
+namespace infrasonic {
+
+/// Heap buffer of trivially copyable T with cache-line aligned storage.
+/// Only reallocates when the requested size actually changes.
+template <typename T, size_t Alignment = 64>
+class AlignedBuffer {
+
+public:
+    static_assert((Alignment & (Alignment - 1)) == 0, "Alignment must be a power of 2");
+
+    AlignedBuffer() = default;
+    ~AlignedBuffer() = default;
+
+    AlignedBuffer(const AlignedBuffer &) = delete;
+    AlignedBuffer &operator=(const AlignedBuffer &) = delete;
+
+    // Resizes (if needed) and zeroes the contents
+    void Resize(const size_t size)
+    {
+        if (size != size_)
+        {
+            storage_.reset(size > 0 ? new uint8_t[size * sizeof(T) + Alignment - 1] : nullptr);
+            const uintptr_t addr = reinterpret_cast<uintptr_t>(storage_.get());
+            data_ = size > 0 ? reinterpret_cast<T *>((addr + Alignment - 1) & ~static_cast<uintptr_t>(Alignment - 1)) : nullptr;
+            size_ = size;
+        }
+        Clear();
+    }
+
+    inline void Clear()
+    {
+        if (data_) std::memset(static_cast<void *>(data_), 0, size_ * sizeof(T));
+    }
+
+    inline T *Data() { return data_; }
+    inline const T *Data() const { return data_; }
+
+    inline T &operator[](const size_t i) { return data_[i]; }
+    inline const T &operator[](const size_t i) const { return data_[i]; }
+
+    inline size_t Size() const { return size_; }
+
+    // Allocated footprint including alignment padding
+    inline size_t Bytes() const { return size_ > 0 ? size_ * sizeof(T) + Alignment - 1 : 0; }
+
+private:
+    std::unique_ptr<uint8_t[]> storage_;
+    T *data_ = nullptr;
+    size_t size_ = 0;
+};
+
+}
+
+#endif
@@ -0,0 +1,87 @@
+#include <cmath>
+#include <utility>
+#include "fft.hpp"
+
+using namespace infrasonic;
+
+static const double kTwoPiD = 6.283185307179586;
+
+void Fft::Init(const size_t size)
+{
+    size_ = size;
+
+    size_t bits = 0;
+    while ((static_cast<size_t>(1) << bits) < size)
+        bits++;
+
+    bitrev_.Resize(size);
+    for (size_t i = 0; i < size; i++)
+    {
+        size_t r = 0;
+        for (size_t b = 0; b < bits; b++)
+            r |= ((i >> b) & 1) << (bits - 1 - b);
+        bitrev_[i] = r;
+    }
+
+    // Twiddles for the largest stage, smaller stages use a stride through them.
+    // Computed in double so the error does not grow with size.
+    cos_.Resize(size / 2);
+    sin_.Resize(size / 2);
+    for (size_t i = 0; i < size / 2; i++)
+    {
+        const double w = kTwoPiD * static_cast<double>(i) / static_cast<double>(size);
+        cos_[i] = static_cast<float>(std::cos(w));
+        sin_[i] = static_cast<float>(std::sin(w));
+    }
+}
+
+void Fft::Forward(float *re, float *im) const
+{
+    transform(re, im, -1.0f);
+}
+
+void Fft::Inverse(float *re, float *im) const
+{
+    transform(re, im, 1.0f);
+    const float scale = 1.0f / static_cast<float>(size_);
+    for (size_t i = 0; i < size_; i++)
+    {
+        re[i] *= scale;
+        im[i] *= scale;
+    }
+}
+
+void Fft::transform(float *re, float *im, const float sign) const
+{
+    for (size_t i = 0; i < size_; i++)
+    {
+        const size_t j = bitrev_[i];
+        if (j > i)
+        {
+            std::swap(re[i], re[j]);
+            std::swap(im[i], im[j]);
+        }
+    }
+
+    for (size_t len = 2; len <= size_; len <<= 1)
+    {
+        const size_t half = len / 2;
+        const size_t stride = size_ / len;
+        for (size_t start = 0; start < size_; start += len)
+        {
+            for (size_t k = 0; k < half; k++)
+            {
+                const float wr = cos_[k * stride];
+                const float wi = sign * sin_[k * stride];
+                const size_t a = start + k;
+                const size_t b = a + half;
+                const float tr = re[b] * wr - im[b] * wi;
+                const float ti = re[b] * wi + im[b] * wr;
+                re[b] = re[a] - tr;
+                im[b] = im[a] - ti;
+                re[a] += tr;
+                im[a] += ti;
+            }
+        }
+    }
+}
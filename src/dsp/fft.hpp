@@ -0,0 +1,44 @@
+#pragma once
+#ifndef INFS_FFT_H
+#define INFS_FFT_H
+
+#include <cstddef>
+#include "aligned_buffer.hpp"
+
+namespace infrasonic
+{
+
+/// In-place iterative radix-2 complex FFT on split real/imaginary arrays.
+///
+/// Init() precomputes twiddles and the bit reversal permutation and allocates,
+/// so it is not realtime safe. Transforms themselves do not allocate.
+class Fft
+{
+  public:
+    Fft() = default;
+    ~Fft() = default;
+
+    Fft(const Fft &) = delete;
+    Fft &operator=(const Fft &) = delete;
+
+    // size must be a power of 2
+    void Init(const size_t size);
+
+    // X[k] = sum x[n] e^(-2 pi i k n / N)
+    void Forward(float *re, float *im) const;
+
+    // x[n] = 1/N sum X[k] e^(2 pi i k n / N), including the 1/N scaling
+    void Inverse(float *re, float *im) const;
+
+    inline size_t GetSize() const { return size_; }
+
+  private:
+    void transform(float *re, float *im, const float sign) const;
+
+    size_t size_ = 0;
+    AlignedBuffer<size_t> bitrev_;
+    AlignedBuffer<float> cos_, sin_;
+};
+
+}
+#endif
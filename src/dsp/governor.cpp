@@ -0,0 +1,70 @@
+#include "governor.hpp"
+
+using namespace infrasonic;
+
+// Time after a change before the load is trusted again, and
+// minimum time at a level before stepping back up
+static const float kSettleTime = 0.02f;
+static const float kHoldTime = 2.0f;
+
+// Smoothing of the per-block load, per block
+static const float kLoadCoef = 0.02f;
+
+// Stepping up must leave at least this much of the budget unused,
+// based on the estimated cost at the higher level
+static const float kHysteresis = 0.7f;
+
+void QualityGovernor::Init(const float block_rate, const int num_ovs_steps)
+{
+    num_ovs_steps_ = num_ovs_steps;
+    max_level_ = num_ovs_steps + 2;
+    settle_blocks_ = static_cast<int>(block_rate * kSettleTime) + 1;
+    hold_blocks_ = static_cast<int>(block_rate * kHoldTime) + 1;
+    level_ = 0;
+    blocks_since_change_ = 0;
+}
+
+void QualityGovernor::SetBudget(const float budget)
+{
+    budget_ = budget;
+}
+
+bool QualityGovernor::Process(const float load)
+{
+    if (budget_ <= 0.0f)
+    {
+        if (level_ == 0)
+            return false;
+        level_ = 0;
+        blocks_since_change_ = 0;
+        return true;
+    }
+
+    // The first block at a new level seeds the average
+    load_ = blocks_since_change_ == 0 ? load : load_ + kLoadCoef * (load - load_);
+    blocks_since_change_++;
+
+    if (blocks_since_change_ < settle_blocks_)
+        return false;
+
+    if (load_ > budget_ && level_ < max_level_)
+    {
+        level_++;
+        blocks_since_change_ = 0;
+        return true;
+    }
+
+    if (level_ > 0 && blocks_since_change_ >= hold_blocks_)
+    {
+        // Undoing an oversampling step roughly doubles the cost, the other steps are smaller
+        const float growth = level_ <= num_ovs_steps_ ? 2.0f : 1.25f;
+        if (load_ * growth < budget_ * kHysteresis)
+        {
+            level_--;
+            blocks_since_change_ = 0;
+            return true;
+        }
+    }
+
+    return false;
+}
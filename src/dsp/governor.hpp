@@ -0,0 +1,48 @@
+#pragma once
+#ifndef INFS_GOVERNOR_H
+#define INFS_GOVERNOR_H
+
+namespace infrasonic
+{
+
+/// Steps processing quality down while measured load exceeds a budget,
+/// and back up with hysteresis once there is enough headroom.
+///
+/// Load is the fraction of real time spent processing, reported once per block.
+/// Quality levels, from 0 (full quality) downwards:
+///   - one level per halving of the oversampling factor, down to 1x
+///   - fast (lower order) math kernels
+///   - auxiliary output off
+///
+/// The governor only decides the level, applying it is up to the caller.
+class QualityGovernor
+{
+  public:
+    QualityGovernor() = default;
+    ~QualityGovernor() = default;
+
+    // Resets to full quality. num_ovs_steps is the number of times
+    // the configured oversampling factor can be halved.
+    void Init(const float block_rate, const int num_ovs_steps);
+
+    // Fraction of real time, 0 disables the governor and returns to full quality
+    void SetBudget(const float budget);
+
+    // Reports one block. Returns true if the level changed.
+    bool Process(const float load);
+
+    inline int GetLevel() const { return level_; }
+    inline int GetOvsSteps() const { return level_ < num_ovs_steps_ ? level_ : num_ovs_steps_; }
+    inline bool GetFastKernels() const { return level_ > num_ovs_steps_; }
+    inline bool GetAltOutDisabled() const { return level_ > num_ovs_steps_ + 1; }
+
+  private:
+    float budget_ = 0.0f;
+    float load_ = 0.0f;
+    int level_ = 0, max_level_ = 0, num_ovs_steps_ = 0;
+    int settle_blocks_ = 1, hold_blocks_ = 1;
+    int blocks_since_change_ = 0;
+};
+
+}
+#endif
@@ -0,0 +1,80 @@
+#pragma once
+#ifndef INFS_HANDOFF_H
+#define INFS_HANDOFF_H
+
+#include <cstddef>
+#include "spsc_queue.hpp"
+
+namespace infrasonic {
+
+/// Passes heap objects built on one thread (the producer, usually the UI) to a realtime
+/// consumer that never allocates or frees them. Objects the consumer is done with are
+/// retired back to the producer, which deletes them the next time it publishes.
+/// Null is a valid object, e.g. to clear something.
+template <typename T, size_t Size = 4>
+class Handoff {
+
+public:
+    Handoff() = default;
+
+    // The consumer's current object is not owned here and must be deleted by its owner
+    ~Handoff()
+    {
+        Collect();
+        T *obj;
+        while (pending_.Pop(obj)) delete obj;
+    }
+
+    Handoff(const Handoff &) = delete;
+    Handoff &operator=(const Handoff &) = delete;
+
+    // Producer thread only. Takes ownership of obj, deleting it and returning false
+    // if the consumer has fallen too far behind.
+    bool Publish(T *obj)
+    {
+        Collect();
+        if (!pending_.Push(obj))
+        {
+            delete obj;
+            return false;
+        }
+        return true;
+    }
+
+    // Producer thread only. Deletes everything the consumer has retired.
+    void Collect()
+    {
+        T *obj;
+        while (retired_.Pop(obj)) delete obj;
+    }
+
+    // Consumer thread only. Takes the newest published object, retiring any it skipped.
+    bool Take(T *&obj)
+    {
+        T *next;
+        bool taken = false;
+        while (pending_.Pop(next))
+        {
+            if (taken) Retire(obj);
+            obj = next;
+            taken = true;
+        }
+        return taken;
+    }
+
+    // Consumer thread only. Hands an object no longer in use back to the producer.
+    // Between two publishes the consumer retires at most Size + 2 objects, so this
+    // only fails (and leaks) if it retires objects that did not come from Take().
+    void Retire(T *obj)
+    {
+        if (obj) retired_.Push(obj);
+    }
+
+private:
+    SpscQueue<T *, Size> pending_;
+    SpscQueue<T *, Size * 2> retired_;
+};
+
+}
+
+#endif
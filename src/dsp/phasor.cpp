@@ -0,0 +1,23 @@
+#include <math.h>
+#include "phasor.hpp"
+
+using namespace infrasonic;
+
+void Phasor::SetFreq(float freq)
+{
+    freq_ = freq;
+    inc_ = static_cast<double>(freq_) / sample_rate_;
+}
+
+float Phasor::Process()
+{
+    float out = static_cast<float>(phs_);
+    out_cycles_ = cycles_;
+
+    phs_ += inc_;
+    const double wraps = floor(phs_);
+    phs_ -= wraps;
+    cycles_ = (cycles_ + static_cast<int>(wraps) + kCycleModulus) % kCycleModulus;
+
+    return out;
+}
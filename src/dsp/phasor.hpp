@@ -0,0 +1,58 @@
+#pragma once
+#ifndef INFS_PHASOR_H
+#define INFS_PHASOR_H
+
+#include <cstdint>
+
+namespace infrasonic
+{
+
+/// Scalar phasor with double precision phase accumulation.
+/// Intended for control-rate use where periods can be minutes long
+/// and a single precision increment would drift audibly.
+class Phasor
+{
+  public:
+    // Cycles are counted modulo this, which every ratio with a denominator of 1, 2, 3, 4 or 6
+    // divides, so phases at those ratios of this phasor can be derived from (cycles + phase)
+    static const int kCycleModulus = 12;
+
+    Phasor() = default;
+    ~Phasor() = default;
+
+    inline void Init(float sample_rate)
+    {
+        sample_rate_ = sample_rate;
+        phs_ = 0.0;
+        cycles_ = out_cycles_ = 0;
+        SetFreq(1.0f);
+    }
+
+    inline void SetSampleRate(float sample_rate)
+    {
+        sample_rate_ = sample_rate;
+        SetFreq(freq_);
+    }
+
+    inline void Reset()
+    {
+        phs_ = 0.0;
+        cycles_ = out_cycles_ = 0;
+    }
+
+    float Process();
+
+    // Whole cycles completed modulo kCycleModulus, for the phase last returned by Process()
+    inline int GetCycles() const { return out_cycles_; }
+
+    void SetFreq(float freq);
+
+  private:
+    float freq_;
+    float sample_rate_;
+    double inc_, phs_;
+    int cycles_, out_cycles_;
+};
+
+}
+#endif
@@ -0,0 +1,103 @@
+#include <algorithm>
+#include <cassert>
+#include <cmath>
+#include <map>
+#include <mutex>
+#include <vector>
+#include "shared_tables.hpp"
+
+using namespace infrasonic;
+
+const size_t SharedTables::kMaxFftBits;
+
+namespace
+{
+
+struct FftRegistry
+{
+    std::mutex mutex;
+    std::unique_ptr<Fft> ffts[SharedTables::kMaxFftBits + 1];
+};
+
+// Keyed by the clamped points, so curves that only differ outside 0-1 share a table
+typedef std::vector<float> WarpTableKey;
+
+struct WarpTableRegistry
+{
+    std::mutex mutex;
+    std::map<WarpTableKey, std::weak_ptr<const WarpTable>> tables;
+};
+
+// Function-local statics are built on first use, and C++11 makes that thread safe
+FftRegistry &fftRegistry()
+{
+    static FftRegistry registry;
+    return registry;
+}
+
+WarpTableRegistry &warpTableRegistry()
+{
+    static WarpTableRegistry registry;
+    return registry;
+}
+
+}
+
+const Fft &SharedTables::GetFft(const size_t size)
+{
+    size_t bits = 0;
+    while ((static_cast<size_t>(1) << bits) < size)
+        bits++;
+    assert((static_cast<size_t>(1) << bits) == size && bits <= kMaxFftBits);
+
+    FftRegistry &registry = fftRegistry();
+    std::lock_guard<std::mutex> lock(registry.mutex);
+    std::unique_ptr<Fft> &fft = registry.ffts[bits];
+    if (!fft)
+    {
+        fft.reset(new Fft());
+        fft->Init(size);
+    }
+    return *fft;
+}
+
+std::shared_ptr<const WarpTable> SharedTables::GetWarpTable(const WarpTable::Point *points, const size_t num_points)
+{
+    if (num_points < 2 || num_points > WarpTable::kMaxPoints)
+        return nullptr;
+
+    WarpTableKey key(num_points * 2);
+    for (size_t i = 0; i < num_points; i++)
+    {
+        if (!std::isfinite(points[i].x) || !std::isfinite(points[i].y))
+            return nullptr;
+        key[i * 2] = std::min(std::max(points[i].x, 0.0f), 1.0f);
+        key[i * 2 + 1] = std::min(std::max(points[i].y, 0.0f), 1.0f);
+    }
+
+    WarpTableRegistry &registry = warpTableRegistry();
+    std::lock_guard<std::mutex> lock(registry.mutex);
+
+    auto it = registry.tables.find(key);
+    if (it != registry.tables.end())
+    {
+        std::shared_ptr<const WarpTable> table = it->second.lock();
+        if (table)
+            return table;
+    }
+
+    std::shared_ptr<WarpTable> table = std::make_shared<WarpTable>();
+    if (!table->Build(points, num_points))
+        return nullptr;
+
+    // Drop entries whose tables have all been released
+    for (auto e = registry.tables.begin(); e != registry.tables.end();)
+    {
+        if (e->second.expired())
+            e = registry.tables.erase(e);
+        else
+            ++e;
+    }
+    registry.tables[key] = table;
+    return table;
+}
@@ -0,0 +1,36 @@
+#pragma once
+#ifndef INFS_SHARED_TABLES_H
+#define INFS_SHARED_TABLES_H
+
+#include <cstddef>
+#include <memory>
+#include "fft.hpp"
+#include "warp_table.hpp"
+
+namespace infrasonic
+{
+
+/// Process-wide registry of read-only tables, shared by every oscillator and module instance
+/// instead of each building its own copy. Tables are built on first use, so nothing is
+/// computed at plugin load, and all storage is 64-byte aligned.
+///
+/// All functions are thread safe. They may build and allocate, so call them from Init() or
+/// the UI thread and keep the result; the audio thread should only read what it was given.
+class SharedTables
+{
+  public:
+    static const size_t kMaxFftBits = 16;
+
+    // FFT plan of a power of 2 size up to 2^kMaxFftBits, kept until exit
+    static const Fft &GetFft(const size_t size);
+
+    // Table for a custom warp curve. Everyone loading the same (clamped) points gets the same
+    // table, which is freed with its last reference. Null if the points are not usable.
+    static std::shared_ptr<const WarpTable> GetWarpTable(const WarpTable::Point *points, const size_t num_points);
+
+  private:
+    SharedTables() = delete;
+};
+
+}
+#endif
@@ -0,0 +1,88 @@
+#pragma once
+#ifndef INFS_SIMD_BACKEND_AVX_H
+#define INFS_SIMD_BACKEND_AVX_H
+
+#include <cstdint>
+#include <immintrin.h>
+
+namespace infrasonic
+{
+namespace simd
+{
+
+/// AVX backend, 8 lanes. Integer work is split into SSE2 halves
+/// since 256-bit integer ops need AVX2.
+struct vfloat
+{
+    static const int size = 8;
+    static const char *Name() { return "avx"; }
+
+    __m256 v;
+
+    vfloat() = default;
+    vfloat(__m256 x) : v(x) {}
+    vfloat(float x) : v(_mm256_set1_ps(x)) {}
+
+    static inline vfloat Load(const float *p) { return _mm256_loadu_ps(p); }
+    inline void Store(float *p) const { _mm256_storeu_ps(p, v); }
+
+    // {0, 1, 2, ... 7}
+    static inline vfloat Ramp() { return _mm256_setr_ps(0.0f, 1.0f, 2.0f, 3.0f, 4.0f, 5.0f, 6.0f, 7.0f); }
+
+    inline float operator[](const int i) const { float t[size]; Store(t); return t[i]; }
+};
+
+inline vfloat operator+(const vfloat &a, const vfloat &b) { return _mm256_add_ps(a.v, b.v); }
+inline vfloat operator-(const vfloat &a, const vfloat &b) { return _mm256_sub_ps(a.v, b.v); }
+inline vfloat operator*(const vfloat &a, const vfloat &b) { return _mm256_mul_ps(a.v, b.v); }
+inline vfloat operator/(const vfloat &a, const vfloat &b) { return _mm256_div_ps(a.v, b.v); }
+
+inline vfloat operator<(const vfloat &a, const vfloat &b) { return _mm256_cmp_ps(a.v, b.v, _CMP_LT_OQ); }
+inline vfloat operator<=(const vfloat &a, const vfloat &b) { return _mm256_cmp_ps(a.v, b.v, _CMP_LE_OQ); }
+inline vfloat operator>(const vfloat &a, const vfloat &b) { return _mm256_cmp_ps(a.v, b.v, _CMP_GT_OQ); }
+inline vfloat operator>=(const vfloat &a, const vfloat &b) { return _mm256_cmp_ps(a.v, b.v, _CMP_GE_OQ); }
+inline vfloat operator==(const vfloat &a, const vfloat &b) { return _mm256_cmp_ps(a.v, b.v, _CMP_EQ_OQ); }
+inline vfloat operator!=(const vfloat &a, const vfloat &b) { return _mm256_cmp_ps(a.v, b.v, _CMP_NEQ_UQ); }
+
+inline vfloat operator&(const vfloat &a, const vfloat &b) { return _mm256_and_ps(a.v, b.v); }
+inline vfloat operator|(const vfloat &a, const vfloat &b) { return _mm256_or_ps(a.v, b.v); }
+inline vfloat operator^(const vfloat &a, const vfloat &b) { return _mm256_xor_ps(a.v, b.v); }
+inline vfloat operator~(const vfloat &a) { return _mm256_xor_ps(a.v, _mm256_castsi256_ps(_mm256_set1_epi32(-1))); }
+inline vfloat operator-(const vfloat &a) { return _mm256_xor_ps(a.v, _mm256_set1_ps(-0.0f)); }
+
+inline vfloat floor(const vfloat &a) { return _mm256_floor_ps(a.v); }
+inline vfloat fmin(const vfloat &a, const vfloat &b) { return _mm256_min_ps(a.v, b.v); }
+inline vfloat fmax(const vfloat &a, const vfloat &b) { return _mm256_max_ps(a.v, b.v); }
+
+// Select a where mask is set, b elsewhere
+inline vfloat ifelse(const vfloat &mask, const vfloat &a, const vfloat &b) { return _mm256_blendv_ps(b.v, a.v, mask.v); }
+
+// One bit per lane, set where the lane's sign bit is set
+inline int movemask(const vfloat &a) { return _mm256_movemask_ps(a.v); }
+
+// 2^n for integer valued n in [-126, 127]
+inline vfloat pow2i(const vfloat &n)
+{
+    const __m256i i = _mm256_cvtps_epi32(n.v);
+    const __m128i bias = _mm_set1_epi32(127);
+    const __m128i lo = _mm_slli_epi32(_mm_add_epi32(_mm256_castsi256_si128(i), bias), 23);
+    const __m128i hi = _mm_slli_epi32(_mm_add_epi32(_mm256_extractf128_si256(i, 1), bias), 23);
+    return _mm256_castsi256_ps(_mm256_insertf128_si256(_mm256_castsi128_si256(lo), hi, 1));
+}
+
+
+// Table lookup, base[index] per lane for integer valued index >= 0
+inline vfloat gather(const float *base, const vfloat &index)
+{
+#ifdef __AVX2__
+    return _mm256_i32gather_ps(base, _mm256_cvttps_epi32(index.v), 4);
+#else
+    alignas(32) int32_t i[8];
+    _mm256_store_si256(reinterpret_cast<__m256i *>(i), _mm256_cvttps_epi32(index.v));
+    return _mm256_setr_ps(base[i[0]], base[i[1]], base[i[2]], base[i[3]], base[i[4]], base[i[5]], base[i[6]], base[i[7]]);
+#endif
+}
+
+}
+}
+#endif
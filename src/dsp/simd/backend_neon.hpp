@@ -0,0 +1,94 @@
+#pragma once
+#ifndef INFS_SIMD_BACKEND_NEON_H
+#define INFS_SIMD_BACKEND_NEON_H
+
+#include <cstdint>
+#include <arm_neon.h>
+
+namespace infrasonic
+{
+namespace simd
+{
+
+/// AArch64 NEON backend, 4 lanes
+struct vfloat
+{
+    static const int size = 4;
+    static const char *Name() { return "neon"; }
+
+    float32x4_t v;
+
+    vfloat() = default;
+    vfloat(float32x4_t x) : v(x) {}
+    vfloat(float x) : v(vdupq_n_f32(x)) {}
+
+    static inline vfloat Load(const float *p) { return vld1q_f32(p); }
+    inline void Store(float *p) const { vst1q_f32(p, v); }
+
+    // {0, 1, 2, 3}
+    static inline vfloat Ramp() { static const float r[size] = {0.0f, 1.0f, 2.0f, 3.0f}; return vld1q_f32(r); }
+
+    inline float operator[](const int i) const { float t[size]; Store(t); return t[i]; }
+};
+
+namespace detail
+{
+    inline uint32x4_t bits(const vfloat &a) { return vreinterpretq_u32_f32(a.v); }
+    inline vfloat from_bits(const uint32x4_t u) { return vreinterpretq_f32_u32(u); }
+}
+
+inline vfloat operator+(const vfloat &a, const vfloat &b) { return vaddq_f32(a.v, b.v); }
+inline vfloat operator-(const vfloat &a, const vfloat &b) { return vsubq_f32(a.v, b.v); }
+inline vfloat operator*(const vfloat &a, const vfloat &b) { return vmulq_f32(a.v, b.v); }
+inline vfloat operator/(const vfloat &a, const vfloat &b) { return vdivq_f32(a.v, b.v); }
+
+inline vfloat operator<(const vfloat &a, const vfloat &b) { return detail::from_bits(vcltq_f32(a.v, b.v)); }
+inline vfloat operator<=(const vfloat &a, const vfloat &b) { return detail::from_bits(vcleq_f32(a.v, b.v)); }
+inline vfloat operator>(const vfloat &a, const vfloat &b) { return detail::from_bits(vcgtq_f32(a.v, b.v)); }
+inline vfloat operator>=(const vfloat &a, const vfloat &b) { return detail::from_bits(vcgeq_f32(a.v, b.v)); }
+inline vfloat operator==(const vfloat &a, const vfloat &b) { return detail::from_bits(vceqq_f32(a.v, b.v)); }
+inline vfloat operator!=(const vfloat &a, const vfloat &b) { return detail::from_bits(vmvnq_u32(vceqq_f32(a.v, b.v))); }
+
+inline vfloat operator&(const vfloat &a, const vfloat &b) { return detail::from_bits(vandq_u32(detail::bits(a), detail::bits(b))); }
+inline vfloat operator|(const vfloat &a, const vfloat &b) { return detail::from_bits(vorrq_u32(detail::bits(a), detail::bits(b))); }
+inline vfloat operator^(const vfloat &a, const vfloat &b) { return detail::from_bits(veorq_u32(detail::bits(a), detail::bits(b))); }
+inline vfloat operator~(const vfloat &a) { return detail::from_bits(vmvnq_u32(detail::bits(a))); }
+inline vfloat operator-(const vfloat &a) { return vnegq_f32(a.v); }
+
+inline vfloat floor(const vfloat &a) { return vrndmq_f32(a.v); }
+
+// As SSE: b wherever either is NaN. vminq/vmaxq would return NaN, vminnmq/vmaxnmq the number.
+inline vfloat fmin(const vfloat &a, const vfloat &b) { return vbslq_f32(vcltq_f32(a.v, b.v), a.v, b.v); }
+inline vfloat fmax(const vfloat &a, const vfloat &b) { return vbslq_f32(vcgtq_f32(a.v, b.v), a.v, b.v); }
+
+// Select a where mask is set, b elsewhere
+inline vfloat ifelse(const vfloat &mask, const vfloat &a, const vfloat &b) { return vbslq_f32(detail::bits(mask), a.v, b.v); }
+
+// One bit per lane, set where the lane's sign bit is set
+inline int movemask(const vfloat &a)
+{
+    static const int32_t shifts[vfloat::size] = {0, 1, 2, 3};
+    const uint32x4_t signs = vshrq_n_u32(detail::bits(a), 31);
+    return static_cast<int>(vaddvq_u32(vshlq_u32(signs, vld1q_s32(shifts))));
+}
+
+// 2^n for integer valued n in [-126, 127]
+inline vfloat pow2i(const vfloat &n)
+{
+    const int32x4_t e = vaddq_s32(vcvtnq_s32_f32(n.v), vdupq_n_s32(127));
+    return vreinterpretq_f32_s32(vshlq_n_s32(e, 23));
+}
+
+
+// Table lookup, base[index] per lane for integer valued index >= 0
+inline vfloat gather(const float *base, const vfloat &index)
+{
+    int32_t i[vfloat::size];
+    vst1q_s32(i, vcvtq_s32_f32(index.v));
+    const float t[vfloat::size] = {base[i[0]], base[i[1]], base[i[2]], base[i[3]]};
+    return vld1q_f32(t);
+}
+
+}
+}
+#endif
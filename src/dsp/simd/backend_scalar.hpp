@@ -0,0 +1,89 @@
+#pragma once
+#ifndef INFS_SIMD_BACKEND_SCALAR_H
+#define INFS_SIMD_BACKEND_SCALAR_H
+
+#include <cmath>
+#include <cstdint>
+#include <cstring>
+
+namespace infrasonic
+{
+namespace simd
+{
+
+/// Plain C++ backend. Lanes are independent scalar floats,
+/// the loops are simple enough for the compiler to auto-vectorize.
+struct vfloat
+{
+    static const int size = 4;
+    static const char *Name() { return "scalar"; }
+
+    float v[size];
+
+    vfloat() = default;
+    vfloat(float x) { for (int i = 0; i < size; i++) v[i] = x; }
+
+    static inline vfloat Load(const float *p) { vfloat r; for (int i = 0; i < size; i++) r.v[i] = p[i]; return r; }
+    inline void Store(float *p) const { for (int i = 0; i < size; i++) p[i] = v[i]; }
+
+    // {0, 1, 2, ...}
+    static inline vfloat Ramp() { vfloat r; for (int i = 0; i < size; i++) r.v[i] = static_cast<float>(i); return r; }
+
+    inline float operator[](const int i) const { return v[i]; }
+};
+
+namespace detail
+{
+    inline uint32_t bits(float x) { uint32_t u; std::memcpy(&u, &x, sizeof(u)); return u; }
+    inline float from_bits(uint32_t u) { float x; std::memcpy(&x, &u, sizeof(x)); return x; }
+    inline float mask(bool b) { return from_bits(b ? 0xffffffffu : 0u); }
+}
+
+#define INFS_SIMD_ARITH_OP(op) \
+    inline vfloat operator op(const vfloat &a, const vfloat &b) { vfloat r; for (int i = 0; i < vfloat::size; i++) r.v[i] = a.v[i] op b.v[i]; return r; }
+INFS_SIMD_ARITH_OP(+)
+INFS_SIMD_ARITH_OP(-)
+INFS_SIMD_ARITH_OP(*)
+INFS_SIMD_ARITH_OP(/)
+#undef INFS_SIMD_ARITH_OP
+
+#define INFS_SIMD_CMP_OP(op) \
+    inline vfloat operator op(const vfloat &a, const vfloat &b) { vfloat r; for (int i = 0; i < vfloat::size; i++) r.v[i] = detail::mask(a.v[i] op b.v[i]); return r; }
+INFS_SIMD_CMP_OP(<)
+INFS_SIMD_CMP_OP(<=)
+INFS_SIMD_CMP_OP(>)
+INFS_SIMD_CMP_OP(>=)
+INFS_SIMD_CMP_OP(==)
+INFS_SIMD_CMP_OP(!=)
+#undef INFS_SIMD_CMP_OP
+
+#define INFS_SIMD_BIT_OP(op) \
+    inline vfloat operator op(const vfloat &a, const vfloat &b) { vfloat r; for (int i = 0; i < vfloat::size; i++) r.v[i] = detail::from_bits(detail::bits(a.v[i]) op detail::bits(b.v[i])); return r; }
+INFS_SIMD_BIT_OP(&)
+INFS_SIMD_BIT_OP(|)
+INFS_SIMD_BIT_OP(^)
+#undef INFS_SIMD_BIT_OP
+
+inline vfloat operator~(const vfloat &a) { vfloat r; for (int i = 0; i < vfloat::size; i++) r.v[i] = detail::from_bits(~detail::bits(a.v[i])); return r; }
+inline vfloat operator-(const vfloat &a) { vfloat r; for (int i = 0; i < vfloat::size; i++) r.v[i] = -a.v[i]; return r; }
+
+inline vfloat floor(const vfloat &a) { vfloat r; for (int i = 0; i < vfloat::size; i++) r.v[i] = std::floor(a.v[i]); return r; }
+inline vfloat fmin(const vfloat &a, const vfloat &b) { vfloat r; for (int i = 0; i < vfloat::size; i++) r.v[i] = a.v[i] < b.v[i] ? a.v[i] : b.v[i]; return r; }
+inline vfloat fmax(const vfloat &a, const vfloat &b) { vfloat r; for (int i = 0; i < vfloat::size; i++) r.v[i] = a.v[i] > b.v[i] ? a.v[i] : b.v[i]; return r; }
+
+// Select a where mask is set, b elsewhere
+inline vfloat ifelse(const vfloat &mask, const vfloat &a, const vfloat &b) { return (mask & a) | (~mask & b); }
+
+// One bit per lane, set where the lane's sign bit is set
+inline int movemask(const vfloat &a) { int m = 0; for (int i = 0; i < vfloat::size; i++) m |= static_cast<int>(detail::bits(a.v[i]) >> 31) << i; return m; }
+
+// 2^n for integer valued n in [-126, 127]
+inline vfloat pow2i(const vfloat &n) { vfloat r; for (int i = 0; i < vfloat::size; i++) r.v[i] = detail::from_bits(static_cast<uint32_t>(static_cast<int32_t>(n.v[i]) + 127) << 23); return r; }
+
+
+// Table lookup, base[index] per lane for integer valued index >= 0
+inline vfloat gather(const float *base, const vfloat &index) { vfloat r; for (int i = 0; i < vfloat::size; i++) r.v[i] = base[static_cast<int32_t>(index.v[i])]; return r; }
+
+}
+}
+#endif
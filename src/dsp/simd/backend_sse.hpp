@@ -0,0 +1,97 @@
+#pragma once
+#ifndef INFS_SIMD_BACKEND_SSE_H
+#define INFS_SIMD_BACKEND_SSE_H
+
+#include <cstdint>
+#include <emmintrin.h>
+#ifdef __SSE4_1__
+#include <smmintrin.h>
+#endif
+
+namespace infrasonic
+{
+namespace simd
+{
+
+/// SSE2 backend, 4 lanes
+struct vfloat
+{
+    static const int size = 4;
+    static const char *Name() { return "sse"; }
+
+    __m128 v;
+
+    vfloat() = default;
+    vfloat(__m128 x) : v(x) {}
+    vfloat(float x) : v(_mm_set1_ps(x)) {}
+
+    static inline vfloat Load(const float *p) { return _mm_loadu_ps(p); }
+    inline void Store(float *p) const { _mm_storeu_ps(p, v); }
+
+    // {0, 1, 2, 3}
+    static inline vfloat Ramp() { return _mm_setr_ps(0.0f, 1.0f, 2.0f, 3.0f); }
+
+    inline float operator[](const int i) const { float t[size]; Store(t); return t[i]; }
+};
+
+inline vfloat operator+(const vfloat &a, const vfloat &b) { return _mm_add_ps(a.v, b.v); }
+inline vfloat operator-(const vfloat &a, const vfloat &b) { return _mm_sub_ps(a.v, b.v); }
+inline vfloat operator*(const vfloat &a, const vfloat &b) { return _mm_mul_ps(a.v, b.v); }
+inline vfloat operator/(const vfloat &a, const vfloat &b) { return _mm_div_ps(a.v, b.v); }
+
+inline vfloat operator<(const vfloat &a, const vfloat &b) { return _mm_cmplt_ps(a.v, b.v); }
+inline vfloat operator<=(const vfloat &a, const vfloat &b) { return _mm_cmple_ps(a.v, b.v); }
+inline vfloat operator>(const vfloat &a, const vfloat &b) { return _mm_cmpgt_ps(a.v, b.v); }
+inline vfloat operator>=(const vfloat &a, const vfloat &b) { return _mm_cmpge_ps(a.v, b.v); }
+inline vfloat operator==(const vfloat &a, const vfloat &b) { return _mm_cmpeq_ps(a.v, b.v); }
+inline vfloat operator!=(const vfloat &a, const vfloat &b) { return _mm_cmpneq_ps(a.v, b.v); }
+
+inline vfloat operator&(const vfloat &a, const vfloat &b) { return _mm_and_ps(a.v, b.v); }
+inline vfloat operator|(const vfloat &a, const vfloat &b) { return _mm_or_ps(a.v, b.v); }
+inline vfloat operator^(const vfloat &a, const vfloat &b) { return _mm_xor_ps(a.v, b.v); }
+inline vfloat operator~(const vfloat &a) { return _mm_xor_ps(a.v, _mm_castsi128_ps(_mm_set1_epi32(-1))); }
+inline vfloat operator-(const vfloat &a) { return _mm_xor_ps(a.v, _mm_set1_ps(-0.0f)); }
+
+inline vfloat floor(const vfloat &a)
+{
+#ifdef __SSE4_1__
+    return _mm_floor_ps(a.v);
+#else
+    // Truncate, then step down where truncation rounded up (negative non-integers).
+    // Only valid within int32 range, which covers every use in the core.
+    const __m128 t = _mm_cvtepi32_ps(_mm_cvttps_epi32(a.v));
+    return _mm_sub_ps(t, _mm_and_ps(_mm_cmpgt_ps(t, a.v), _mm_set1_ps(1.0f)));
+#endif
+}
+
+inline vfloat fmin(const vfloat &a, const vfloat &b) { return _mm_min_ps(a.v, b.v); }
+inline vfloat fmax(const vfloat &a, const vfloat &b) { return _mm_max_ps(a.v, b.v); }
+
+// Select a where mask is set, b elsewhere
+inline vfloat ifelse(const vfloat &mask, const vfloat &a, const vfloat &b)
+{
+    return _mm_or_ps(_mm_and_ps(mask.v, a.v), _mm_andnot_ps(mask.v, b.v));
+}
+
+// One bit per lane, set where the lane's sign bit is set
+inline int movemask(const vfloat &a) { return _mm_movemask_ps(a.v); }
+
+// 2^n for integer valued n in [-126, 127]
+inline vfloat pow2i(const vfloat &n)
+{
+    const __m128i e = _mm_add_epi32(_mm_cvtps_epi32(n.v), _mm_set1_epi32(127));
+    return _mm_castsi128_ps(_mm_slli_epi32(e, 23));
+}
+
+
+// Table lookup, base[index] per lane for integer valued index >= 0
+inline vfloat gather(const float *base, const vfloat &index)
+{
+    alignas(16) int32_t i[4];
+    _mm_store_si128(reinterpret_cast<__m128i *>(i), _mm_cvttps_epi32(index.v));
+    return _mm_setr_ps(base[i[0]], base[i[1]], base[i[2]], base[i[3]]);
+}
+
+}
+}
+#endif
@@ -0,0 +1,118 @@
+#pragma once
+#ifndef INFS_SIMD_FUNCTIONS_H
+#define INFS_SIMD_FUNCTIONS_H
+
+#include "vfloat.hpp"
+#include "../util.hpp"
+
+/// Math functions for vfloat, built only on the backend primitives
+
+namespace infrasonic
+{
+namespace simd
+{
+
+inline vfloat clamp(const vfloat &x, const vfloat &lo, const vfloat &hi)
+{
+    return fmin(fmax(x, lo), hi);
+}
+
+// Fractional part, always in [0, 1)
+inline vfloat fract(const vfloat &x)
+{
+    return x - floor(x);
+}
+
+// Reduces x in cycles to [-0.25, 0.25] cycles with the same sine
+inline vfloat sin2pi_reduce(const vfloat &x)
+{
+    // Reduce to [-0.5, 0.5], then fold using sin(pi - a) = sin(a)
+    vfloat r = x - floor(x + 0.5f);
+    r = ifelse(r > 0.25f, 0.5f - r, r);
+    return ifelse(r < -0.25f, -0.5f - r, r);
+}
+
+// sin(2 * pi * x), x in cycles. Max error ~1e-7.
+inline vfloat sin2pi(const vfloat &x)
+{
+    const vfloat t = sin2pi_reduce(x) * kTwoPi;
+    const vfloat t2 = t * t;
+    vfloat p = -2.5052108e-8f;
+    p = p * t2 + 2.7557319e-6f;
+    p = p * t2 - 1.9841270e-4f;
+    p = p * t2 + 8.3333333e-3f;
+    p = p * t2 - 1.6666667e-1f;
+    p = p * t2 + 1.0f;
+    return p * t;
+}
+
+// cos(2 * pi * x), x in cycles
+inline vfloat cos2pi(const vfloat &x)
+{
+    return sin2pi(x + 0.25f);
+}
+
+// 2^x, relative error ~1e-7. Input is clamped to the normal float range.
+inline vfloat exp2(const vfloat &x)
+{
+    const vfloat xc = clamp(x, -126.0f, 126.0f);
+    const vfloat n = floor(xc + 0.5f);
+    const vfloat f = (xc - n) * kLn2;
+
+    vfloat p = 1.0f / 720.0f;
+    p = p * f + 1.0f / 120.0f;
+    p = p * f + 1.0f / 24.0f;
+    p = p * f + 1.0f / 6.0f;
+    p = p * f + 0.5f;
+    p = p * f + 1.0f;
+    p = p * f + 1.0f;
+    return p * pow2i(n);
+}
+
+inline vfloat exp(const vfloat &x)
+{
+    return exp2(x * kLog2e);
+}
+
+// Lower order versions of the above for the fast kernel tier,
+// with errors still below -80 dB
+
+// sin(2 * pi * x), x in cycles. Max error ~7e-5.
+inline vfloat sin2pi_fast(const vfloat &x)
+{
+    const vfloat t = sin2pi_reduce(x) * kTwoPi;
+    const vfloat t2 = t * t;
+    vfloat p = 7.5134e-3f;
+    p = p * t2 - 1.65670e-1f;
+    p = p * t2 + 9.996949e-1f;
+    return p * t;
+}
+
+inline vfloat cos2pi_fast(const vfloat &x)
+{
+    return sin2pi_fast(x + 0.25f);
+}
+
+// 2^x, relative error ~6e-5
+inline vfloat exp2_fast(const vfloat &x)
+{
+    const vfloat xc = clamp(x, -126.0f, 126.0f);
+    const vfloat n = floor(xc + 0.5f);
+    const vfloat f = xc - n;
+
+    vfloat p = 9.61813e-3f;
+    p = p * f + 5.550410e-2f;
+    p = p * f + 2.4022650e-1f;
+    p = p * f + 6.9314718e-1f;
+    p = p * f + 1.0f;
+    return p * pow2i(n);
+}
+
+inline vfloat exp_fast(const vfloat &x)
+{
+    return exp2_fast(x * kLog2e);
+}
+
+}
+}
+#endif
@@ -0,0 +1,54 @@
+#pragma once
+#ifndef INFS_SIMD_VFLOAT_H
+#define INFS_SIMD_VFLOAT_H
+
+/// Portable SIMD float vector used by the DSP core.
+///
+/// Exactly one backend is compiled in, selected by defining one of:
+///   INFS_SIMD_BACKEND_SCALAR - plain C++, 4 lanes, no intrinsics
+///   INFS_SIMD_BACKEND_SSE    - SSE2 (SSE4.1 floor when available), 4 lanes
+///   INFS_SIMD_BACKEND_AVX    - AVX, 8 lanes
+///   INFS_SIMD_BACKEND_NEON   - AArch64 NEON, 4 lanes
+/// If none is defined, SSE is used on x86, NEON on AArch64 and scalar otherwise.
+///
+/// Every backend provides `vfloat` with a compile time lane count `vfloat::size`,
+/// arithmetic and comparison operators (comparisons return bit masks), bitwise
+/// mask operators, and the primitives floor(), fmin(), fmax(), ifelse(),
+/// movemask(), pow2i() and gather(). Everything else is built on those in functions.hpp.
+
+#if !defined(INFS_SIMD_BACKEND_SCALAR) && !defined(INFS_SIMD_BACKEND_SSE) && !defined(INFS_SIMD_BACKEND_AVX) && !defined(INFS_SIMD_BACKEND_NEON)
+    #if defined(__SSE2__) || defined(_M_X64)
+        #define INFS_SIMD_BACKEND_SSE
+    #elif defined(__aarch64__) || defined(_M_ARM64)
+        #define INFS_SIMD_BACKEND_NEON
+    #else
+        #define INFS_SIMD_BACKEND_SCALAR
+    #endif
+#endif
+
+#if defined(INFS_SIMD_BACKEND_AVX)
+    #include "backend_avx.hpp"
+#elif defined(INFS_SIMD_BACKEND_SSE)
+    #include "backend_sse.hpp"
+#elif defined(INFS_SIMD_BACKEND_NEON)
+    #include "backend_neon.hpp"
+#else
+    #include "backend_scalar.hpp"
+#endif
+
+namespace infrasonic
+{
+namespace simd
+{
+
+inline vfloat &operator+=(vfloat &a, const vfloat &b) { return a = a + b; }
+inline vfloat &operator-=(vfloat &a, const vfloat &b) { return a = a - b; }
+inline vfloat &operator*=(vfloat &a, const vfloat &b) { return a = a * b; }
+inline vfloat &operator/=(vfloat &a, const vfloat &b) { return a = a / b; }
+inline vfloat &operator&=(vfloat &a, const vfloat &b) { return a = a & b; }
+inline vfloat &operator|=(vfloat &a, const vfloat &b) { return a = a | b; }
+
+}
+}
+
+#endif
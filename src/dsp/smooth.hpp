@@ -44,9 +44,14 @@ public:
     {
         switch (smooth_type_) {
             case SmoothType::Exponential:
-                // one pole lowpass
-                value_ += c_ * (target_ - value_);
+            {
+                // one pole lowpass. In float it stalls short of the target once the step
+                // rounds away (about 2e-5 off at 1 for 20 ms at 192 kHz), and on its way to 0
+                // it decays deep into denormals first. Either way it is close enough to snap.
+                const float next = value_ + c_ * (target_ - value_);
+                value_ = (next == value_ || fabsf(target_ - next) < kSnapThreshold) ? target_ : next;
                 break;
+            }
             case SmoothType::Linear:
                 if (value_ != target_)
                 {
@@ -96,6 +101,8 @@ public:
     inline float GetTime() const { return time_; }
 
 private:
+    static constexpr float kSnapThreshold = 1e-9f;
+
     SmoothType smooth_type_;
     float sample_rate_, time_;
     float c_;
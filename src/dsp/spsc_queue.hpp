@@ -0,0 +1,68 @@
+#pragma once
+#ifndef INFS_SPSC_QUEUE_H
+#define INFS_SPSC_QUEUE_H
+
+#include <atomic>
+#include <cstddef>
+
+namespace infrasonic {
+
+/// Wait-free single-producer single-consumer queue with fixed capacity.
+/// Never allocates or blocks: Push() fails when full and Pop() fails when empty.
+/// T should be cheap to copy, items are copied in and out.
+template <typename T, size_t Size>
+class SpscQueue {
+
+public:
+    static_assert(Size >= 2 && (Size & (Size - 1)) == 0, "Size must be a power of 2");
+
+    SpscQueue() = default;
+    ~SpscQueue() = default;
+
+    SpscQueue(const SpscQueue &) = delete;
+    SpscQueue &operator=(const SpscQueue &) = delete;
+
+    // Producer thread only
+    bool Push(const T &item)
+    {
+        const size_t w = write_.value.load(std::memory_order_relaxed);
+        if (w - read_.value.load(std::memory_order_acquire) == Size) return false;
+        items_[w & (Size - 1)] = item;
+        write_.value.store(w + 1, std::memory_order_release);
+        return true;
+    }
+
+    // Consumer thread only
+    bool Pop(T &item)
+    {
+        const size_t r = read_.value.load(std::memory_order_relaxed);
+        if (r == write_.value.load(std::memory_order_acquire)) return false;
+        item = items_[r & (Size - 1)];
+        read_.value.store(r + 1, std::memory_order_release);
+        return true;
+    }
+
+    // Consumer thread only
+    bool Empty() const
+    {
+        return read_.value.load(std::memory_order_relaxed) == write_.value.load(std::memory_order_acquire);
+    }
+
+private:
+    static const size_t kCacheLine = 64;
+
+    // Padded so producer and consumer never write to the same cache line
+    struct Index {
+        std::atomic<size_t> value{0};
+        char pad[kCacheLine - sizeof(std::atomic<size_t>)];
+    };
+
+    // Indices increase monotonically and are masked on access
+    Index write_;
+    Index read_;
+    T items_[Size];
+};
+
+}
+
+#endif
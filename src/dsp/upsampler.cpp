@@ -0,0 +1,75 @@
+#include <math.h>
+#include <algorithm>
+#include "upsampler.hpp"
+#include "util.hpp"
+
+using namespace infrasonic;
+using namespace infrasonic::simd;
+
+const size_t PolyphaseUpsampler::kMaxFactor;
+const size_t PolyphaseUpsampler::kMaxTapsPerPhase;
+
+void PolyphaseUpsampler::Init(const size_t factor, const size_t taps_per_phase)
+{
+    factor_ = std::min(std::max(factor, static_cast<size_t>(1)), kMaxFactor);
+    taps_ = factor_ > 1 ? std::min(std::max(taps_per_phase, static_cast<size_t>(1)), kMaxTapsPerPhase) : 1;
+
+    // Prototype lowpass at the input Nyquist frequency, Blackman-Harris windowed
+    const size_t len = factor_ * taps_;
+    const float center = (len - 1) * 0.5f;
+    for (size_t p = 0; p < factor_; p++)
+    {
+        float sum = 0.0f;
+        for (size_t j = 0; j < taps_; j++)
+        {
+            const size_t i = j * factor_ + p;
+            const float x = (i - center) / factor_;
+            const float sinc = x == 0.0f ? 1.0f : sinf(kPi * x) / (kPi * x);
+            float win = 1.0f;
+            if (len > 1)
+            {
+                const float t = kTwoPi * i / (len - 1);
+                win = 0.35875f - 0.48829f * cosf(t) + 0.14128f * cosf(2.0f * t) - 0.01168f * cosf(3.0f * t);
+            }
+            // j counts backwards in time from the newest input
+            coefs_[p][taps_ - 1 - j] = sinc * win;
+            sum += sinc * win;
+        }
+
+        // Unity DC gain per phase, so constant PM offsets are passed through exactly
+        for (size_t k = 0; k < taps_; k++)
+        {
+            coefs_[p][k] /= sum;
+        }
+    }
+
+    Reset();
+}
+
+void PolyphaseUpsampler::Reset()
+{
+    pos_ = 0;
+    for (size_t k = 0; k < kMaxTapsPerPhase * 2; k++)
+    {
+        hist_[k] = 0.0f;
+    }
+}
+
+void PolyphaseUpsampler::Process(const vfloat in, vfloat *out)
+{
+    hist_[pos_] = in;
+    hist_[pos_ + taps_] = in;
+    pos_ = (pos_ + 1 == taps_) ? 0 : pos_ + 1;
+
+    const vfloat *x = &hist_[pos_];
+    for (size_t p = 0; p < factor_; p++)
+    {
+        const float *c = coefs_[p];
+        vfloat acc = x[0] * c[0];
+        for (size_t k = 1; k < taps_; k++)
+        {
+            acc += x[k] * c[k];
+        }
+        out[p] = acc;
+    }
+}
@@ -0,0 +1,49 @@
+#pragma once
+#ifndef INFS_UPSAMPLER_SIMD_H
+#define INFS_UPSAMPLER_SIMD_H
+
+#include <cstddef>
+#include "simd/vfloat.hpp"
+
+namespace infrasonic
+{
+namespace simd
+{
+
+/// Polyphase windowed-sinc interpolator for vfloat::size independent channels,
+/// one channel per SIMD lane. Each input frame produces `factor`
+/// interpolated output frames.
+///
+/// A filter length of 1 tap per phase degenerates to a zero-order hold.
+class PolyphaseUpsampler
+{
+  public:
+    static const size_t kMaxFactor = 16;
+    static const size_t kMaxTapsPerPhase = 16;
+
+    PolyphaseUpsampler() = default;
+    ~PolyphaseUpsampler() = default;
+
+    // Designs the filter, which is not realtime safe for large sizes
+    void Init(const size_t factor, const size_t taps_per_phase);
+    void Reset();
+
+    // Push one frame and write `factor` frames to out
+    void Process(const vfloat in, vfloat *out);
+
+    inline size_t GetFactor() const { return factor_; }
+
+  private:
+    size_t factor_ = 1, taps_ = 1;
+    size_t pos_ = 0;
+
+    // Phase-major, ordered oldest to newest input to match history
+    float coefs_[kMaxFactor][kMaxTapsPerPhase];
+
+    // History is written twice so the filter window is always contiguous
+    vfloat hist_[kMaxTapsPerPhase * 2];
+};
+
+}
+}
+#endif
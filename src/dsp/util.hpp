@@ -6,12 +6,23 @@
 
 namespace infrasonic {
 
+static const float kPi = 3.14159265358979f;
+static const float kTwoPi = 2.0f * kPi;
+static const float kLn2 = 0.69314718056f;
+static const float kLog2e = 1.44269504089f;
+
 // Coefficient for one pole smoothing filter based on Tau time constant for `time_s`
 inline float onepole_coef(float time_s, float sample_rate) {
     if (time_s <= 0.0f || sample_rate <= 0.0f) { return 1.0f; }
     return fmin(1.0f / (time_s * sample_rate), 1.0f);
 }
 
+// Clamps x to lo - hi, with NaN going to lo like simd::clamp
+inline float fclamp(float x, float lo, float hi)
+{
+    return x > lo ? (x < hi ? x : hi) : lo;
+}
+
 inline float onepole_coef_t60(float time_s, float sample_rate)
 {
 	return onepole_coef(time_s * 0.1447597f, sample_rate);
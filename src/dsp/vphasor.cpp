@@ -0,0 +1,44 @@
+#include "vphasor.hpp"
+
+using namespace infrasonic::simd;
+
+void VPhasor::SetFreq(float freq)
+{
+    freq_ = freq;
+    inc_ = (freq_ * vfloat::size) / sample_rate_;
+    phs_ = phs_[0] + vfloat::Ramp() * (inc_ / vfloat::size);
+    // Lanes now ahead of lane 0 by more than a cycle boundary count it when they wrap
+    cycles_ = cycles_[0];
+}
+
+vfloat VPhasor::Process()
+{
+    vfloat out;
+
+    // Whole cycles, as up to Nyquist a step can cover several of them. That is still far
+    // fewer than kCycleModulus, so one conditional subtraction keeps the count in range.
+    phs_ = fmax(0.0f, phs_);
+    const vfloat wrapped = floor(phs_);
+    phs_ -= wrapped;
+    cycles_ += wrapped;
+    cycles_ -= (cycles_ >= static_cast<float>(Phasor::kCycleModulus)) & static_cast<float>(Phasor::kCycleModulus);
+
+    out = phs_;
+    phs_ += inc_;
+
+    return out;
+}
+
+void VPhasor::Sync(vfloat &phase, vfloat &cycles, const int lane, const float frac)
+{
+    const float inc = inc_ / vfloat::size;
+    const vfloat after = vfloat::Ramp() >= static_cast<float>(lane);
+    const vfloat restarted = (vfloat::Ramp() - static_cast<float>(lane) + frac) * inc;
+    const vfloat restarted_cycles = floor(restarted);
+    phase = ifelse(after, restarted - restarted_cycles, phase);
+    cycles = ifelse(after, restarted_cycles, cycles);
+
+    // Every lane of the next step is past the restart
+    phs_ = (vfloat::Ramp() + static_cast<float>(vfloat::size - lane) + frac) * inc;
+    cycles_ = 0.0f;
+}
@@ -0,0 +1,59 @@
+#pragma once
+#ifndef INFS_PHASOR_SIMD_H
+#define INFS_PHASOR_SIMD_H
+
+#include <cstdint>
+#include "phasor.hpp"
+#include "simd/vfloat.hpp"
+
+namespace infrasonic
+{
+namespace simd
+{
+
+/// Phasor which operates on a SIMD vector of vfloat::size consecutive samples
+class VPhasor
+{
+  public:
+    VPhasor() = default;
+    ~VPhasor() = default; 
+
+    inline void Init(float sample_rate)
+    {
+        sample_rate_ = sample_rate;
+        phs_ = 0.0f;
+        cycles_ = 0.0f;
+        SetFreq(1.0f);
+    }
+
+    inline void SetSampleRate(float sample_rate)
+    {
+      sample_rate_ = sample_rate;
+      SetFreq(freq_);
+    } 
+
+    // Phases 0-1 of the next vfloat::size samples, at any frequency up to Nyquist
+    vfloat Process();
+
+    void SetFreq(float freq);
+
+    // Whole cycles completed per lane modulo Phasor::kCycleModulus, as whole-valued floats,
+    // for the phases last returned by Process()
+    inline vfloat GetCycles() const { return cycles_; }
+
+    // Hard sync. Restarts the cycle `frac` (0-1) of a sample before lane `lane` of the phases
+    // last returned by Process(), correcting them and their cycle counts from that lane on.
+    // GetCycles() is not valid again until the next Process().
+    void Sync(vfloat &phase, vfloat &cycles, const int lane, const float frac);
+
+    // Phase increment per sample
+    inline float GetIncrement() const { return inc_ / vfloat::size; }
+
+  private:
+    float freq_, inc_;
+    float sample_rate_;
+    vfloat phs_, cycles_;
+};
+}
+}
+#endif
@@ -0,0 +1,118 @@
+#include <cmath>
+#include <algorithm>
+#include <atomic>
+#include "warp_table.hpp"
+#include "simd/functions.hpp"
+
+using namespace infrasonic;
+using namespace infrasonic::simd;
+
+const size_t WarpTable::kMaxPoints;
+const int WarpTable::kSize;
+const int WarpTable::kNumAmounts;
+const int WarpTable::kRowStride;
+
+// Tables can be built on any thread
+static std::atomic<uint32_t> next_id(1);
+
+bool WarpTable::Build(const Point *points, const size_t num_points)
+{
+    if (num_points < 2 || num_points > kMaxPoints)
+        return false;
+
+    for (size_t i = 0; i < num_points; i++)
+    {
+        if (!std::isfinite(points[i].x) || !std::isfinite(points[i].y))
+            return false;
+        points_[i].x = std::min(std::max(points[i].x, 0.0f), 1.0f);
+        points_[i].y = std::min(std::max(points[i].y, 0.0f), 1.0f);
+        if (i > 0 && points_[i].x < points_[i - 1].x)
+            return false;
+    }
+    num_points_ = num_points;
+    id_ = next_id++;
+
+    table_.Resize((kNumAmounts + 1) * kRowStride);
+
+    for (int r = 0; r <= kNumAmounts; r++)
+    {
+        const float amt = static_cast<float>(r) / kNumAmounts;
+        float *row = &table_[r * kRowStride];
+        for (int i = 0; i <= kSize; i++)
+        {
+            const float x = static_cast<float>(i) / kSize;
+            const float y = Curve(x);
+            if (amt <= 0.5f)
+            {
+                const float t = amt * 2.0f;
+                row[i] = x + (y - x) * t;
+            }
+            else
+            {
+                const float t = amt * 2.0f - 1.0f;
+                row[i] = y + (Curve(y) - y) * t;
+            }
+        }
+    }
+
+    return true;
+}
+
+vfloat WarpTable::Process(const vfloat phase, const vfloat amt) const
+{
+    // Branch-free bilinear lookup, the upper index is clamped so the
+    // guard point is only ever read with a fractional weight of 1
+    const vfloat x = clamp(phase, 0.0f, 1.0f) * static_cast<float>(kSize);
+    const vfloat y = clamp(amt, 0.0f, 1.0f) * static_cast<float>(kNumAmounts);
+    const vfloat xi = fmin(floor(x), static_cast<float>(kSize - 1));
+    const vfloat yi = fmin(floor(y), static_cast<float>(kNumAmounts - 1));
+    const vfloat xf = x - xi;
+    const vfloat yf = y - yi;
+
+    const float *t = table_.Data();
+    const vfloat idx = yi * static_cast<float>(kRowStride) + xi;
+    const vfloat a = gather(t, idx);
+    const vfloat b = gather(t + 1, idx);
+    const vfloat c = gather(t + kRowStride, idx);
+    const vfloat d = gather(t + kRowStride + 1, idx);
+
+    const vfloat lo = a + (b - a) * xf;
+    const vfloat hi = c + (d - c) * xf;
+    return lo + (hi - lo) * yf;
+}
+
+float WarpTable::Process(const float phase, const float amt) const
+{
+    // NaN-safe, a NaN index would read far outside the table
+    const float x = fclamp(phase, 0.0f, 1.0f) * kSize;
+    const float y = fclamp(amt, 0.0f, 1.0f) * kNumAmounts;
+    const int xi = std::min(static_cast<int>(x), kSize - 1);
+    const int yi = std::min(static_cast<int>(y), kNumAmounts - 1);
+    const float xf = x - xi;
+    const float yf = y - yi;
+
+    const float *row = &table_[yi * kRowStride + xi];
+    const float lo = row[0] + (row[1] - row[0]) * xf;
+    const float hi = row[kRowStride] + (row[kRowStride + 1] - row[kRowStride]) * xf;
+    return lo + (hi - lo) * yf;
+}
+
+// Piecewise linear through the breakpoints, held flat beyond the first and last
+float WarpTable::Curve(const float x) const
+{
+    if (x <= points_[0].x)
+        return points_[0].y;
+
+    for (size_t i = 1; i < num_points_; i++)
+    {
+        const Point &p0 = points_[i - 1];
+        const Point &p1 = points_[i];
+        if (x <= p1.x)
+        {
+            const float dx = p1.x - p0.x;
+            return dx > 0.0f ? p0.y + (p1.y - p0.y) * (x - p0.x) / dx : p1.y;
+        }
+    }
+
+    return points_[num_points_ - 1].y;
+}
@@ -0,0 +1,66 @@
+#pragma once
+#ifndef INFS_WARP_TABLE_H
+#define INFS_WARP_TABLE_H
+
+#include <cstddef>
+#include <cstdint>
+#include "aligned_buffer.hpp"
+#include "simd/vfloat.hpp"
+
+namespace infrasonic
+{
+
+/// User-defined phase transfer curve, tabulated as a family of curves indexed by amount.
+///
+/// The curve is given as breakpoints (x, y) in 0-1 and is linearly interpolated between them.
+/// Amount 0 is the identity, 0.5 is the curve itself and 1 is the curve applied to its own
+/// output, blended linearly in between. Lookup is bilinear over phase and amount.
+///
+/// Building allocates and is not realtime safe. A built table is immutable,
+/// so it can be shared with the audio thread by pointer.
+class WarpTable
+{
+  public:
+    struct Point
+    {
+        float x, y;
+    };
+
+    static const size_t kMaxPoints = 256;
+
+    WarpTable() = default;
+    ~WarpTable() = default;
+
+    WarpTable(const WarpTable &) = delete;
+    WarpTable &operator=(const WarpTable &) = delete;
+
+    // Points must be sorted by x, at least 2 and at most kMaxPoints.
+    // Values are clamped to 0-1. Returns false if the points are not usable.
+    bool Build(const Point *points, const size_t num_points);
+
+    // phase and amt in 0-1
+    simd::vfloat Process(const simd::vfloat phase, const simd::vfloat amt) const;
+    float Process(const float phase, const float amt) const;
+
+    inline const Point *GetPoints() const { return points_; }
+    inline size_t GetNumPoints() const { return num_points_; }
+
+    // Unique to each build, unlike the address, which a later table may reuse. 0 before Build().
+    inline uint32_t GetId() const { return id_; }
+
+  private:
+    // Segments along phase and amount, each row has one extra guard point
+    static const int kSize = 256;
+    static const int kNumAmounts = 16;
+    static const int kRowStride = kSize + 16; // keeps rows cache line aligned
+
+    float Curve(const float x) const;
+
+    AlignedBuffer<float> table_;
+    Point points_[kMaxPoints];
+    size_t num_points_ = 0;
+    uint32_t id_ = 0;
+};
+
+}
+#endif
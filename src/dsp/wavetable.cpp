@@ -0,0 +1,119 @@
+#include <algorithm>
+#include "wavetable.hpp"
+#include "shared_tables.hpp"
+#include "simd/functions.hpp"
+
+using namespace infrasonic;
+using namespace infrasonic::simd;
+
+void MipmapWavetable::Init()
+{
+    for (size_t l = 0; l < kNumLevels; l++)
+        ffts_[l] = &SharedTables::GetFft(kSize >> l);
+
+    // Channels start on cache lines
+    size_t offset = 0;
+    for (size_t l = 0; l < kNumLevels; l++)
+    {
+        const size_t stride = ((kSize >> l) + kGuard + 15) / 16 * 16;
+        offsets_[l][0] = offset;
+        offsets_[l][1] = offset + stride;
+        offset += stride * 2;
+    }
+    table_.Resize(offset);
+    build_step_ = 0;
+}
+
+void MipmapWavetable::CopyFrom(const MipmapWavetable &other)
+{
+    std::copy(other.table_.Data(), other.table_.Data() + other.table_.Size(), table_.Data());
+    build_step_ = other.build_step_;
+}
+
+bool MipmapWavetable::Build()
+{
+    float *top_re = table_.Data() + offsets_[0][0];
+    float *top_im = table_.Data() + offsets_[0][1];
+
+    switch (build_step_)
+    {
+        case 0:
+            // Both real channels in one complex transform. Truncating the spectrum
+            // symmetrically keeps each channel real, so they stay separable.
+            ffts_[0]->Forward(top_re, top_im);
+            break;
+
+        case 1:
+            // Lower levels read their bins from the top level's spectrum
+            for (size_t l = 1; l < kNumLevels; l++)
+            {
+                const size_t size = kSize >> l;
+                const size_t harmonics = GetHarmonics(l);
+                const float scale = static_cast<float>(size) / kSize;
+                float *re = table_.Data() + offsets_[l][0];
+                float *im = table_.Data() + offsets_[l][1];
+                std::fill(re, re + size, 0.0f);
+                std::fill(im, im + size, 0.0f);
+                for (size_t k = 0; k <= harmonics; k++)
+                {
+                    re[k] = top_re[k] * scale;
+                    im[k] = top_im[k] * scale;
+                }
+                for (size_t k = 1; k <= harmonics; k++)
+                {
+                    re[size - k] = top_re[kSize - k] * scale;
+                    im[size - k] = top_im[kSize - k] * scale;
+                }
+                ffts_[l]->Inverse(re, im);
+            }
+            break;
+
+        case 2:
+            // The top level last, in place
+            std::fill(top_re + kMaxHarmonics + 1, top_re + kSize - kMaxHarmonics, 0.0f);
+            std::fill(top_im + kMaxHarmonics + 1, top_im + kSize - kMaxHarmonics, 0.0f);
+            ffts_[0]->Inverse(top_re, top_im);
+            for (size_t l = 0; l < kNumLevels; l++)
+            {
+                const size_t size = kSize >> l;
+                for (int c = 0; c < 2; c++)
+                {
+                    float *t = table_.Data() + offsets_[l][c];
+                    t[size] = t[0];
+                    t[size + 1] = t[1];
+                }
+            }
+            break;
+
+        default:
+            return true;
+    }
+
+    build_step_++;
+    return IsReady();
+}
+
+int MipmapWavetable::GetLevel(const float harmonics)
+{
+    if (!(harmonics <= kMaxHarmonics))
+        return -1;
+
+    int level = 0;
+    while (level < static_cast<int>(kNumLevels) - 1 && GetHarmonics(level + 1) >= harmonics)
+        level++;
+    return level;
+}
+
+vfloat MipmapWavetable::Process(const int channel, const int level, const vfloat phase) const
+{
+    // Wrapped, and the index clamped (NaN included) so no phase can read outside the level.
+    // The guard points cover a wrapped phase that rounds up to 1.
+    const float size = static_cast<float>(kSize >> level);
+    const float *t = table_.Data() + offsets_[level][channel];
+    const vfloat x = fract(phase) * size;
+    const vfloat i = fmin(floor(x), size - 1.0f);
+    const vfloat frac = x - i;
+    const vfloat a = gather(t, i);
+    const vfloat b = gather(t + 1, i);
+    return a + (b - a) * frac;
+}
@@ -0,0 +1,78 @@
+#pragma once
+#ifndef INFS_WAVETABLE_H
+#define INFS_WAVETABLE_H
+
+#include <cstddef>
+#include "aligned_buffer.hpp"
+#include "fft.hpp"
+#include "simd/vfloat.hpp"
+
+namespace infrasonic
+{
+
+/// Band-limited mipmap of one single-cycle waveform pair (main and alt output), used to play
+/// back a settled oscillator at high pitch instead of synthesizing it sample by sample.
+///
+/// Level l keeps harmonics up to kMaxHarmonics >> l in kOversample samples per period of
+/// its highest harmonic, so linear interpolation stays accurate. The owner writes one cycle
+/// into the top level through GetCycle(), then Build() band-limits it in place a step at a
+/// time so the FFT work can be spread over several blocks.
+///
+/// Init() allocates (about 33 KB) and is not realtime safe, nothing else allocates.
+/// CopyFrom() needs both tables initialized.
+class MipmapWavetable
+{
+  public:
+    static const size_t kMaxHarmonics = 128;
+    static const size_t kNumLevels = 8;
+    static const size_t kOversample = 16;
+    static const size_t kSize = kMaxHarmonics * kOversample;
+
+    MipmapWavetable() = default;
+    ~MipmapWavetable() = default;
+
+    MipmapWavetable(const MipmapWavetable &) = delete;
+    MipmapWavetable &operator=(const MipmapWavetable &) = delete;
+
+    void Init();
+
+    // Discards the levels, after which a new cycle can be written
+    inline void Reset() { build_step_ = 0; }
+
+    // Takes over another allocated table's contents and build progress, without allocating
+    void CopyFrom(const MipmapWavetable &other);
+
+    // kSize points of channel 0 (main) or 1 (alt) at phases i / kSize, to be written by the owner
+    inline float *GetCycle(const int channel) { return table_.Data() + offsets_[0][channel]; }
+
+    // Band-limits the written cycle into all levels, one step per call.
+    // Returns true once every level is ready.
+    bool Build();
+
+    inline bool IsReady() const { return build_step_ == kNumBuildSteps; }
+    inline bool IsAllocated() const { return table_.Size() > 0; }
+
+    // Level with the fewest harmonics that still covers `harmonics`, or -1 if none has enough
+    static int GetLevel(const float harmonics);
+
+    static inline size_t GetHarmonics(const int level) { return kMaxHarmonics >> level; }
+
+    // Interpolated lookup at phase 0-1, any other phase is wrapped into it
+    simd::vfloat Process(const int channel, const int level, const simd::vfloat phase) const;
+
+  private:
+    static const int kNumBuildSteps = 3;
+
+    // Each channel of each level has two guard points so phase 1 needs no wrapping
+    static const size_t kGuard = 2;
+
+    // One transform per level size, shared with every other table
+    const Fft *ffts_[kNumLevels] = {};
+
+    AlignedBuffer<float> table_;
+    size_t offsets_[kNumLevels][2];
+    int build_step_ = 0;
+};
+
+}
+#endif